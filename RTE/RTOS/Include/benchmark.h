@@ -0,0 +1,68 @@
+/*! \file benchmark.h
+    \brief This header file defines the kernel benchmark
+		\details The benchmark loads the kernel with extra threads so the cost of the kernel handlers
+		         can be read from \ref kernel_stats while the demo threads run, and measures the time a
+		         high priority thread stays blocked on a mutex in \ref bench_stats, as well as the context switches
+		         saved by a preemption threshold and the cost of a yield.
+*/
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include "kernel.h"
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Benchmark Configuration ----------------------------------
+//
+//  <e> Kernel Benchmark
+//          <i> Create the benchmark threads and collect kernel statistics.
+//
+#define ENABLE_BENCHMARK 0 ///< benchmark flag: 1 = create the benchmark threads; 0 = no benchmark
+//
+//    <q> Filler Threads
+//          <i> Fill every free thread slot (up to MAX_THREADS) with filler threads.
+//
+#define BENCHMARK_FILLERS 1 ///< filler threads flag: 1 = fill the free thread slots; 0 = no filler threads
+//
+//    <q> Mutex Blocking Time
+//          <i> A low, a medium and a high priority thread play out a priority inversion on a mutex.
+//          <i> Needs 3 free thread slots. Compare the results with and without OS_MUTEX_INHERITANCE.
+//
+#define BENCHMARK_MUTEX 1 ///< mutex benchmark flag: 1 = measure the mutex blocking time; 0 = no mutex benchmark
+//
+//    <q> Preemption Threshold
+//          <i> Three cooperating threads of the same priority, like thread0/thread1/thread2, take turns on the processor.
+//          <i> Needs 3 free thread slots. Compare kernel_stats.pendsv_cnt per bench_stats.pt_rounds with and without BENCH_PT_THRESHOLD.
+//
+#define BENCHMARK_THRESHOLD 0 ///< preemption threshold benchmark flag: 1 = count the context switches of cooperating threads; 0 = no threshold benchmark
+//
+//    <q> Yield Round Trip
+//          <i> A realtime priority thread measures osThreadYield when no other thread takes over.
+//          <i> Needs 1 free thread slot. Compare bench_stats.yield_cycles_min with and without ENABLE_FAST_YIELD.
+//
+#define BENCHMARK_YIELD 0 ///< yield benchmark flag: 1 = measure the yield round trip; 0 = no yield benchmark
+//  </e>
+
+#if ((ENABLE_BENCHMARK == 1) && (ENABLE_KERNEL_STATS != 1))
+#error "The benchmark reports through kernel_stats, ENABLE_KERNEL_STATS must be set"
+#endif
+
+/*! \struct os_bench_stats
+    Benchmark measurements, in core clock cycles.
+*/
+typedef struct os_bench_stats
+{
+	uint32_t mutex_block_cnt;        ///< Number of times the high priority thread waited on the mutex
+	uint32_t mutex_block_cycles;     ///< Cycles the high priority thread was blocked on the mutex the last time
+	uint32_t mutex_block_cycles_max; ///< Worst case cycles the high priority thread was blocked on the mutex
+	uint32_t pt_rounds;              ///< Number of work rounds completed by the preemption threshold threads
+	uint32_t yield_cnt;              ///< Number of measured yields
+	uint32_t yield_cycles;           ///< Cycles spent in the last measured yield
+	uint32_t yield_cycles_min;       ///< Best case cycles of a yield, without interrupts or context switches
+} os_bench_stats;
+
+extern os_bench_stats bench_stats;
+
+int Init_benchmark (void);
+
+#endif // _BENCHMARK_H
@@ -228,7 +228,9 @@ typedef void (*os_ptimer) (void const *argument);
 
 typedef struct os_thread_cb os_thread_cb;       ///< Thread Control Block 
 typedef struct os_semaphore_cb os_semaphore_cb; ///< Semaphore Control Block 
-typedef struct os_thread_timed os_thread_timed; ///< Sleeping Thread  
+typedef struct os_timer_cb os_timer_cb;         ///< Timer Control Block 
+typedef struct os_mutex_cb os_mutex_cb;         ///< Mutex Control Block 
+typedef struct os_thread_timed os_thread_timed; ///< Thread blocked on a semaphore  
 
 
 /// Thread ID identifies the thread (pointer to a thread control block).
@@ -270,10 +272,34 @@ struct os_thread_cb
 	uint32_t stack_size;   ///< Stack Size (bytes)
 	uint32_t semaphore_p;  ///< Semapore Pointer - where the thread is in semaphore blocked queue 
 	osSemaphoreId semaphore_id; ///< Semaphore ID for semaphore currently blocked on 
-	uint32_t time_count;   ///< Time until Timeout
-	uint32_t timed_q_p;    ///< Timed Queue Pointer
-	osStatus timed_ret;    ///< Exit Status from Sleep
+	osPriority base_priority;   ///< Priority set by the thread definition or \ref osThreadSetPriority; \ref priority may be raised above it by mutex priority inheritance or a semaphore priority ceiling
+	osMutexId mutex_id;    ///< Mutex ID for mutex currently blocked on 
+	osMutexId mutex_held;  ///< First of the mutexes owned by the thread
+	osSemaphoreId ceiling_held; ///< First of the semaphores with a priority ceiling owned by the thread
+	uint32_t time_count;   ///< Time until Timeout (ticks after the previous entry of the Waiting Queue expires)
+	uint32_t timed_q_p;    ///< Timed Queue Pointer (\ref MAX_THREADS when not in the Waiting Queue)
+	osStatus timed_ret;    ///< Exit Status from Sleep or Wait (\ref osErrorResource while still waiting)
 	os_pthread start_p;    ///< Start address of thread function
+	uint32_t ready_lvl;    ///< Ready to Run Queue level the thread is linked in (\ref OS_NO_Q when not linked)
+	osThreadId ready_next; ///< Next thread in the same Ready to Run Queue level
+	osThreadId ready_prev; ///< Previous thread in the same Ready to Run Queue level
+	uint32_t quantum;      ///< Round-robin time slice in ticks (0 = no time slicing)
+	uint32_t slice;        ///< Ticks left in the current time slice
+	osPriority threshold;  ///< Preemption threshold: while running, only threads above it preempt the thread (\ref osPriorityError = none)
+	osThreadClass sched_class; ///< Scheduling class of the thread
+	uint32_t partition;    ///< Time partition of the thread (0 = runs in every window)
+	uint32_t period;       ///< Period in ticks of an EDF or rate-monotonic thread (0 = fixed-priority thread)
+	uint32_t wcet;         ///< Worst-case execution time in ticks of a rate-monotonic thread
+	uint32_t release;      ///< Release tick of the current job
+	uint32_t deadline;     ///< Absolute deadline of the current job (release + period)
+	uint32_t budget;       ///< Execution budget in ticks per replenishment period (0 = no budget enforcement)
+	uint32_t budget_left;  ///< Ticks left in the execution budget, the thread runs at \ref OS_BUDGET_PRIORITY at most once used up
+	uint32_t budget_period; ///< Budget replenishment period in ticks
+	uint32_t budget_repl;  ///< System tick the budget is replenished at, counted from the first tick charged since the last replenishment
+	osThreadId budget_next; ///< Next thread with an execution budget
+	uint32_t aging;        ///< Priority levels gained by aging while waiting ready (\ref OS_AGING)
+	uint32_t aging_ran;    ///< Set when the thread ran since the last aging pass
+	uint32_t lock_cnt;     ///< Scheduler lock nesting count (\ref osKernelLock), preemption is deferred while not 0
 };
 
 // Thread related information for initialization and scheduling
@@ -281,14 +307,18 @@ extern osThreadId th_q[MAX_THREADS];
 extern uint32_t th_q_h;
 extern uint32_t th_q_cnt;
 
+// Timeouts of threads waiting in the Waiting Queue (timed_q)
+osStatus os_TimedQInsert (osThreadId thread_id, uint32_t ticks);
+void os_TimedQRemove (osThreadId thread_id);
+void os_TimedQTick (void);
+uint32_t os_TimedQNext (void);
+
 /*! \struct os_thread_timed
-    Expiry time for a thread structure.
+    Semaphore blocked queue entry. The timeout of the thread, if any, is kept in the Waiting Queue.
 */
 struct os_thread_timed
 {
-	osThreadId threadId;   ///< Thread timed
-	uint32_t   expiryTime; ///< Expiry time
-	uint32_t   ticks; 		 ///< Ticks	
+	osThreadId threadId;   ///< Thread blocked
 };
 
 /// Semaphore Block Control
@@ -299,6 +329,32 @@ struct os_semaphore_cb
 	osThreadId                 threads_own_q[MAX_THREADS_SEM]; ///< queue of threads using a semaphore.
   uint32_t                   threads_own_q_cnt;              ///< indicated how many threads are using on this semaphore	
 	uint32_t                   ownCount;                       ///< number of tokens for this semaphore
+	uint32_t                   given_tokens;                   ///< tokens given by interrupt handlers or non-owner threads and not taken yet
+	osPriority                 ceiling;                        ///< priority the owner is raised to (\ref osPriorityError for no ceiling)
+	osSemaphoreId              ceiling_next;                   ///< next ceiling semaphore owned by the same thread
+} ;
+
+/// Timer Block Control
+struct os_timer_cb
+{
+	os_ptimer                  ptimer;                         ///< timer call back function
+	void                      *argument;                       ///< argument of the timer call back function
+	os_timer_type              type;                           ///< one-shot or periodic timer
+	uint32_t                   load;                           ///< timer period in ticks
+	uint32_t                   time_count;                     ///< ticks after the previous entry of the Timer Queue expires
+	uint32_t                   timer_q_p;                      ///< Timer Queue index (\ref MAX_TIMERS when the timer is stopped)
+	uint32_t                   pending;                        ///< expirations not yet dispatched by the timer thread
+	osTimerId                  pending_next;                   ///< next timer waiting for the timer thread
+} ;
+
+/// Mutex Block Control
+struct os_mutex_cb
+{
+	osThreadId                 owner;                          ///< thread owning the mutex, NULL when free
+	uint32_t                   lock_cnt;                       ///< number of times the owner locked the mutex
+	osMutexId                  owner_next;                     ///< next mutex owned by the same thread
+	osThreadId                 threads_q[MAX_THREADS];         ///< queue of threads blocked on the mutex, in arrival order
+	uint32_t                   threads_q_cnt;                  ///< indicated how many threads are blocked on this mutex
 } ;
 
 
@@ -309,8 +365,14 @@ typedef struct os_thread_def  {
   osPriority             tpriority;    ///< initial thread priority
   uint32_t               instances;    ///< maximum number of instances of that thread function
   uint32_t               stacksize;    ///< stack size requirements in bytes; 0 is default stack size
-// 	uint32_t               period;       ///< thread period
-// 	uint32_t               rel_time;     ///< thread release time	(initial)
+  uint32_t               quantum;      ///< round-robin time slice in ticks; 0 runs the thread until it blocks or yields
+  uint32_t               period;       ///< thread period in millisec for the EDF and rate-monotonic scheduling classes; 0 for a fixed-priority thread
+  uint32_t               rel_time;     ///< thread release time (initial) in millisec, counted from the thread creation
+  uint32_t               wcet;         ///< worst-case execution time in millisec of a rate-monotonic thread
+  uint32_t               budget;       ///< execution budget in millisec per replenishment period; 0 for no budget enforcement
+  uint32_t               budget_period; ///< budget replenishment period in millisec
+  osPriority             threshold;    ///< preemption threshold; \ref osPriorityError for none
+  uint32_t               partition;    ///< time partition; 0 for a thread running in every partition window
 } osThreadDef_t;
 
 /// Timer Definition structure contains timer parameters.
@@ -329,6 +391,7 @@ typedef struct os_mutex_def  {
 /// \note CAN BE CHANGED: \b os_semaphore_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_semaphore_def  {
   uint32_t                   dummy;    ///< dummy value.	
+  osPriority                 ceiling;  ///< ceiling priority of a binary semaphore; osPriorityError for no ceiling
 } osSemaphoreDef_t;
 
 /// Definition structure for memory block allocation.
@@ -389,6 +452,19 @@ osStatus osKernelStart (void);
 /// \return 0 RTOS is not started, 1 RTOS is started.
 int32_t osKernelRunning(void);
 
+/// Lock the scheduler: the running thread is not preempted until the matching \ref osKernelUnlock.
+/// \details The lock nests and interrupts stay enabled. A reschedule requested while locked runs at the unlock.
+///          A thread that blocks or sleeps still gives up the processor, the lock applies again once it runs.
+/// \return status code that indicates the execution status of the function.
+/// \note RavenOS specific extension, not to be called from interrupt service routines.
+osStatus osKernelLock (void);
+
+/// Unlock the scheduler locked by \ref osKernelLock.
+/// \details When the last lock is released, the reschedule deferred while locked runs.
+/// \return status code that indicates the execution status of the function.
+/// \note RavenOS specific extension, not to be called from interrupt service routines.
+osStatus osKernelUnlock (void);
+
 #if (defined (osFeature_SysTick)  &&  (osFeature_SysTick != 0))     // System Timer available
 
 /// Get the RTOS kernel system timer counter 
@@ -422,7 +498,112 @@ extern const osThreadDef_t os_thread_def_##name
 #else                            // define the object
 #define osThreadDef(name, priority, instances, stacksz)  \
 const osThreadDef_t os_thread_def_##name = \
-{ (name), (priority), (instances), (stacksz)  }
+{ (name), (priority), (instances), (stacksz), (OS_ROBIN_QUANTUM), 0, 0, 0, 0, 0, osPriorityError, 0  }
+#endif
+
+/// Create a Thread Definition with a round-robin time slice of its own.
+/// \param         name         name of the thread function.
+/// \param         priority     initial priority of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         quantum      round-robin time slice in ticks; 0 runs the thread until it blocks or yields.
+/// \note RavenOS specific extension of \ref osThreadDef.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefRR(name, priority, instances, stacksz, quantum)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefRR(name, priority, instances, stacksz, quantum)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), (quantum), 0, 0, 0, 0, 0, osPriorityError, 0  }
+#endif
+
+/// Create a Thread Definition for the Earliest-Deadline-First scheduling class.
+/// \param         name         name of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         period       thread period in millisec, the deadline of each job is the end of its period.
+/// \param         rel_time     first release time in millisec after the thread creation.
+/// \note RavenOS specific extension of \ref osThreadDef. EDF threads run at \ref OS_EDF_PRIORITY, earliest deadline first,
+///       and end each job with \ref osThreadPeriodWait.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefEDF(name, instances, stacksz, period, rel_time)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefEDF(name, instances, stacksz, period, rel_time)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (osPriority) (OS_EDF_PRIORITY), (instances), (stacksz), 0, (period), (rel_time), 0, 0, 0, osPriorityError, 0  }
+#endif
+
+/// Create a Thread Definition for the Rate-Monotonic scheduling class.
+/// \param         name         name of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         period       thread period in millisec, the deadline of each job is the end of its period.
+/// \param         wcet         worst-case execution time of a job in millisec.
+/// \param         rel_time     first release time in millisec after the thread creation.
+/// \note RavenOS specific extension of \ref osThreadDef. The kernel assigns the priority from the period, between
+///       \ref OS_RM_PRIORITY_MIN and \ref OS_RM_PRIORITY_MAX, and \ref osThreadCreate fails when the rate-monotonic 
+///       threads would miss their deadlines. Each job ends with \ref osThreadPeriodWait.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefRM(name, instances, stacksz, period, wcet, rel_time)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefRM(name, instances, stacksz, period, wcet, rel_time)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), osPriorityError, (instances), (stacksz), 0, (period), (rel_time), (wcet), 0, 0, osPriorityError, 0  }
+#endif
+
+/// Create a Thread Definition with an execution budget.
+/// \param         name         name of the thread function.
+/// \param         priority     initial priority of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         budget       execution time in millisec the thread may use at its priority per replenishment period.
+/// \param         budget_period replenishment period in millisec, counted from the first tick the thread runs after a replenishment.
+/// \note RavenOS specific extension of \ref osThreadDef. Once the budget is used up the thread runs at \ref OS_BUDGET_PRIORITY
+///       until the budget is replenished, so it cannot hold off the lower priority threads for longer than its budget.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefBudget(name, priority, instances, stacksz, budget, budget_period)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefBudget(name, priority, instances, stacksz, budget, budget_period)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), (OS_ROBIN_QUANTUM), 0, 0, 0, (budget), (budget_period), osPriorityError, 0  }
+#endif
+
+/// Create a Thread Definition with a preemption threshold.
+/// \param         name         name of the thread function.
+/// \param         priority     initial priority of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         threshold    priority the thread is protected up to while it runs, not below \a priority.
+/// \note RavenOS specific extension of \ref osThreadDef. Once running, the thread is only preempted by threads 
+///       above \a threshold and is not time sliced. It still gives way when it blocks, sleeps or calls \ref osThreadYield.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefPT(name, priority, instances, stacksz, threshold)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefPT(name, priority, instances, stacksz, threshold)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), 0, 0, 0, 0, 0, 0, (threshold), 0  }
+#endif
+
+/// Create a Thread Definition for a time partition.
+/// \param         name         name of the thread function.
+/// \param         priority     initial priority of the thread function.
+/// \param         instances    number of possible thread instances.
+/// \param         stacksz      stack size (in bytes) requirements for the thread function.
+/// \param         partition    time partition of the thread, from 1 to \ref OS_PARTITIONS - 1.
+/// \note RavenOS specific extension of \ref osThreadDef. The thread only runs inside the windows of its partition
+///       in the major frame \ref OS_PARTITION_FRAME, scheduled by priority against the threads of the same partition
+///       and the threads defined without a partition.
+#if defined (osObjectsExternal)  // object is external
+#define osThreadDefPart(name, priority, instances, stacksz, partition)  \
+extern const osThreadDef_t os_thread_def_##name
+#else                            // define the object
+#define osThreadDefPart(name, priority, instances, stacksz, partition)  \
+const osThreadDef_t os_thread_def_##name = \
+{ (name), (priority), (instances), (stacksz), (OS_ROBIN_QUANTUM), 0, 0, 0, 0, 0, osPriorityError, (partition)  }
 #endif
 
 /// Access a Thread definition.
@@ -468,6 +649,23 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority);
 /// \note MUST REMAIN UNCHANGED: \b osThreadGetPriority shall be consistent in every CMSIS-RTOS.
 osPriority osThreadGetPriority (osThreadId thread_id);
 
+/// Wait for the next period of an EDF or rate-monotonic thread (end of the current job).
+/// \details The next job is released one period after the current one and gets the end of that period as deadline.
+/// \return \ref osEventTimeout when the thread slept until its next release, \ref osOK when the next release 
+///         already passed (overrun) and the thread did not sleep, or an error code.
+/// \note RavenOS specific extension, for threads defined with \ref osThreadDefEDF or \ref osThreadDefRM.
+osStatus osThreadPeriodWait (void);
+
+/// \brief Update the priority of a thread from its base priority, the ceiling of the semaphores it owns and the priority of the threads waiting on its mutexes.
+/// \param[in]     thread_id  thread object.
+void os_ThreadUpdatePriority (osThreadId thread_id);
+
+/// \brief Take the running thread out of the ready threads and wait until it is woken up.
+/// \param[in]     status     state of the thread while waiting: TH_BLOCKED or TH_ASLEEP.
+/// \return the exit status set by the waker or the timeout.
+/// \note Must be called with the kernel in a critical section, it leaves the critical section.
+osStatus os_ThreadBlock (osThreadStatus status);
+
 
 //  ==== Generic Wait Functions ====
 
@@ -476,6 +674,13 @@ osPriority osThreadGetPriority (osThreadId thread_id);
 /// \return status code that indicates the execution status of the function.
 osStatus osDelay (uint32_t millisec);
 
+/// Wait until the next period boundary (Periodic Time Delay).
+/// \param[in,out] previous_wake  system tick of the previous wake up, set with \ref osKernelSysTick before the first call.
+/// \param[in]     millisec       period value
+/// \return status code that indicates the execution status of the function.
+/// \note CAN BE CHANGED: \b osDelayUntil is an extension of this CMSIS-RTOS.
+osStatus osDelayUntil (uint32_t *previous_wake, uint32_t millisec);
+
 #if (defined (osFeature_Wait)  &&  (osFeature_Wait != 0))     // Generic Wait available
 
 /// Wait for Signal, Message, Mail, or Timeout.
@@ -607,6 +812,14 @@ osStatus osMutexRelease (osMutexId mutex_id);
 /// \note MUST REMAIN UNCHANGED: \b osMutexDelete shall be consistent in every CMSIS-RTOS.
 osStatus osMutexDelete (osMutexId mutex_id);
 
+/// \brief Release the mutexes owned by a thread and stop waiting on a mutex.
+/// \param[in]     thread_id  thread object.
+void os_MutexRemoveThread (osThreadId thread_id);
+
+/// \brief Remove a thread from the queue of the mutex it is blocked on.
+/// \param[in]     thread_id  thread object.
+void os_MutexRemoveWaiter (osThreadId thread_id);
+
 
 //  ==== Semaphore Management Functions ====
 
@@ -621,7 +834,19 @@ osStatus osMutexDelete (osMutexId mutex_id);
 extern const osSemaphoreDef_t os_semaphore_def_##name
 #else                            // define the object
 #define osSemaphoreDef(name)  \
-const osSemaphoreDef_t os_semaphore_def_##name = { 0 }
+const osSemaphoreDef_t os_semaphore_def_##name = { 0, (osPriorityError) }
+#endif
+
+/// Define a binary Semaphore object with a priority ceiling.
+/// \param         name          name of the semaphore object.
+/// \param         ceiling       priority the owner of the semaphore is raised to, at least the highest priority of the threads using it.
+/// \note CAN BE CHANGED: \b osSemaphoreDefCeiling is an extension of this CMSIS-RTOS, the semaphore must be created with a count of 1.
+#if defined (osObjectsExternal)  // object is external
+#define osSemaphoreDefCeiling(name, ceiling)  \
+extern const osSemaphoreDef_t os_semaphore_def_##name
+#else                            // define the object
+#define osSemaphoreDefCeiling(name, ceiling)  \
+const osSemaphoreDef_t os_semaphore_def_##name = { 0, (ceiling) }
 #endif
 
 /// Access a Semaphore definition.
@@ -662,6 +887,12 @@ osStatus osSemaphoreDelete (osSemaphoreId semaphore_id);
 /// \return status code that indicates the execution status of the function.
 osStatus os_SemaphoreRemoveThread (osThreadId thread_id);
 
+/// \brief Remove thread from a blocked semaphore queue.
+/// \param[in]     thread_id     thread object.
+/// \param[in]     semaphore_id  semaphore object.
+/// \return status code that indicates the execution status of the function.
+osStatus os_RemoveThreadFromSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id);
+
 #endif     // Semaphore available
 
 
@@ -0,0 +1,49 @@
+/*! \file irqthreads.h
+    \brief This header file defines the threaded interrupt handlers
+		\details Defines the number of interrupt sources that can be bound to threads and the interface of the IRQ threads.
+*/
+
+#ifndef _IRQTHREADS_H
+#define _IRQTHREADS_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- IRQ Thread Configuration ----------------------------------
+//
+//  <e> Threaded Interrupt Handlers
+//          <i> An interrupt source bound to a thread with osIrqAttach is masked by the kernel when it fires and the thread is made ready,
+//          <i> the thread handles the interrupt at its own priority and unmasks the source with osIrqWait.
+//          <i> The vector table is copied to RAM (1 KB) at the first osIrqAttach.
+//
+#define ENABLE_IRQ_THREADS 0 ///< IRQ threads flag: 1 = interrupt sources can be bound to threads; 0 = no IRQ threads
+//
+//      <o> Number of IRQ Threads <1-16>
+//          <i> Specifies the maximum number of interrupt sources bound to threads at the same time.
+//
+#define OS_IRQ_THREADS 4 ///< The maximum number of interrupt sources bound to threads
+//  </e>
+
+#if ((ENABLE_IRQ_THREADS) && (ENABLE_IRQ_THREADS == 1))
+/*! \struct os_irq_thread
+    Interrupt source bound to a thread.
+*/
+typedef struct os_irq_thread
+{
+	osThreadId        thread_id; ///< thread handling the interrupt, NULL for a free entry
+	int32_t           irqn;      ///< interrupt number (IRQn_Type)
+	volatile uint32_t pending;   ///< set by the interrupt, cleared when the thread takes it in \ref osIrqWait
+	uint32_t          masked;    ///< set while the source is masked by the kernel
+	uint32_t          wait;      ///< set while the thread is blocked in \ref osIrqWait
+} os_irq_thread;
+
+osStatus osIrqAttach (int32_t irqn);
+osStatus osIrqWait (uint32_t millisec);
+osStatus osIrqDetach (void);
+
+void os_IrqHandler (void);
+void os_IrqRemoveThread (osThreadId thread_id);
+#endif
+
+#endif // _IRQTHREADS_H
@@ -1,6 +1,6 @@
 /*! \file kernel.h
     \brief This header file defines all kernel related data
-		\details Makes available the context switch API for threads.
+		\details Makes available the context switch API for threads and the kernel statistics.
 */
 
 #ifndef _KERNEL_H
@@ -8,9 +8,62 @@
 
 #include <stdint.h>
 
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Kernel Configuration ----------------------------------
+//
+//      <o> System Call Priority Ceiling <1-7>
+//          <i> NVIC priority level of the kernel (0 is the highest). The kernel critical sections and handlers mask only the
+//          <i> interrupts at this level and below. Interrupts of a higher level (lower value) are never delayed by the kernel,
+//          <i> but must not call any RTOS function.
+//
+#define OS_SYSCALL_PRIORITY 2 ///< NVIC priority ceiling of the kernel: interrupts with a lower priority value are never masked by the kernel
+//
+//  <e> Kernel Statistics
+//          <i> Measure the kernel handlers with the DWT cycle counter. Results are kept in kernel_stats.
+//
+#define ENABLE_KERNEL_STATS 0 ///< kernel statistics flag: 1 = collect statistics; 0 = do not collect statistics
+//  </e>
+//
+//  <e> Tickless Idle
+//          <i> While only the Idle thread can run, stretch the SysTick period up to the next thread timeout
+//          <i> instead of running the scheduler at every tick. The Idle thread sleeps (WFI) in between.
+//
+#define ENABLE_TICKLESS_IDLE 1 ///< tickless idle flag: 1 = stop the periodic tick while idle; 0 = tick at every period
+//  </e>
+//
+//  <e> Cooperative Scheduling
+//          <i> The system tick only keeps time, wakes up the threads whose timeout expired and expires the timers: it never preempts.
+//          <i> Threads switch at osThreadYield, blocking calls and releases only. Round-robin time slices, execution budgets,
+//          <i> priority aging and partition windows are not enforced.
+//
+#define ENABLE_COOPERATIVE 0 ///< cooperative scheduling flag: 1 = no preemption from the system tick; 0 = preemptive scheduling
+//  </e>
+//
+//  <e> Fast Yield
+//          <i> The threads run privileged, so they call the scheduler directly and pend PendSV instead of trapping into the SVC handler.
+//          <i> Disable to yield through SVC 1, for instance to compare the yield cost with the BENCHMARK_YIELD benchmark.
+//
+#define ENABLE_FAST_YIELD 1 ///< fast yield flag: 1 = threads run the scheduler directly; 0 = threads yield through an SVC call
+//  </e>
+
+/*! \struct os_kernel_stats
+    Kernel handler measurements, times in core clock cycles.
+*/
+typedef struct os_kernel_stats
+{
+	uint32_t systick_cnt;        ///< Number of measured \ref SysTick_Handler runs
+	uint32_t systick_cycles;     ///< Cycles spent in the last \ref SysTick_Handler run
+	uint32_t systick_cycles_max; ///< Worst case cycles spent in \ref SysTick_Handler
+	uint32_t pendsv_cnt;         ///< Number of context switches requested from \ref PendSV_Handler
+	uint32_t crit_cycles_max;    ///< Worst case cycles the kernel critical sections masked the interrupts up to \ref OS_SYSCALL_PRIORITY
+} os_kernel_stats;
+
+extern os_kernel_stats kernel_stats;
+
 void os_KernelInvokeScheduler (void);
 void os_KernelStackAlloc (uint32_t thread_idx);
+void os_KernelEnterCriticalSection (void);
+void os_KernelExitCriticalSection (void);
 
 
 #endif
-
@@ -0,0 +1,26 @@
+/*! \file mutexes.h
+    \brief This header file defines all mutex related data
+		\details Defines the maximum number of mutexes and whether the mutex owners inherit the priority of the threads they block.
+*/
+
+#ifndef _MUTEXES_H
+#define _MUTEXES_H
+
+#include <stdint.h>
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Mutex Configuration ----------------------------------
+//
+//      <o> Number of Mutexes <1-32>
+//          <i> Specifies the maximum number of mutexes that can be created.
+//
+#define MAX_MUTEXES 8 ///< The maximum number of mutexes supported
+//
+//  <e> Priority Inheritance
+//          <i> A thread owning a mutex runs at the priority of the highest priority thread blocked on it, through chains of mutexes.
+//          <i> Disable only to measure the priority inversion it prevents.
+//
+#define OS_MUTEX_INHERITANCE 1 ///< priority inheritance flag: 1 = mutex owners inherit the priority of the blocked threads; 0 = no inheritance
+//  </e>
+
+#endif // _MUTEXES_H
@@ -1,10 +1,146 @@
 /*! \file scheduler.h
-    \brief This header file defines scheduler related data 
+    \brief This header file defines scheduler related data
+		\details Defines the Ready-to-Run queue: one FIFO per priority level and a bitmap of the non-empty levels,
+		         for each time partition, the scheduling policy operations, the major frame of the partition windows and the schedule table of the cyclic executive.
 */
 
 #ifndef _SCHEDULER_H
 #define _SCHEDULER_H
 
+#include <stdint.h>
+#include "cmsis_os.h"
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Partition Configuration ----------------------------------
+//
+//      <o> Number of Time Partitions <1-8>
+//          <i> Threads defined with osThreadDefPart belong to partitions 1 and up, and only run inside the windows of their partition.
+//          <i> Partition 0 holds the other threads (Idle and timer threads included), they run in every window.
+//          <i> 1 disables the time partitioning.
+//
+#define OS_PARTITIONS 1 ///< Number of time partitions, partition 0 included (1 = no time partitioning)
+
+/*! \def OS_PARTITION_FRAME
+         Major frame: the partition windows in order, as { partition, length in ticks }, repeated for ever.
+         A window of partition 0 only runs the threads of partition 0. Used when \ref OS_PARTITIONS is above 1. */
+#define OS_PARTITION_FRAME { {1, 50}, {2, 30}, {0, 20} }
+
+//
+//      <o> Scheduling Policy
+//              <0=> Built-in: priority levels, round-robin, EDF
+//              <1=> Custom: operations table OS_SCHED_OPS
+//          <i> The built-in policy is called directly. A custom policy is called through the os_sched_ops table named by OS_SCHED_OPS.
+//
+#define OS_SCHED_POLICY 0 ///< Scheduling policy: 0 = built-in policy; 1 = custom operations table \ref OS_SCHED_OPS
+
+/*! \def OS_SCHED_OPS
+         Name of the const \ref os_sched_ops table of the custom scheduling policy. Used when \ref OS_SCHED_POLICY is 1. */
+#define OS_SCHED_OPS os_sched_custom
+//
+//  <e> Cyclic Executive
+//          <i> Replay the schedule table OS_CYCLIC_TABLE every hyperperiod: SysTick_Handler dispatches the thread of each entry
+//          <i> at its tick offset, with no priority decision. A thread runs until the next entry or until it yields, blocks or sleeps.
+//          <i> Only the threads in the table run, set OS_TIMER_ISR_DISPATCH for the timers.
+//
+#define ENABLE_CYCLIC_EXECUTIVE 0 ///< cyclic executive flag: 1 = dispatch from the schedule table; 0 = priority scheduling
+//
+//    <o> Hyperperiod (Ticks) <1-1000000>
+//          <i> Length of the schedule table, replayed for ever.
+//
+#define OS_CYCLIC_HYPERPERIOD 100 ///< Hyperperiod of the cyclic executive in ticks
+//  </e>
+
+/*! \def OS_CYCLIC_TABLE
+         Schedule table of the cyclic executive: { tick offset in the hyperperiod, thread function }, offsets in increasing order.
+         A NULL thread function leaves the processor to the Idle thread. Used when \ref ENABLE_CYCLIC_EXECUTIVE is set. */
+#define OS_CYCLIC_TABLE { {0, thread0}, {40, thread1}, {70, thread2}, {90, NULL} }
+
+/*! \struct os_cyclic_entry
+    Entry of the cyclic executive schedule table.
+*/
+typedef struct os_cyclic_entry
+{
+	uint32_t   offset;   ///< Tick offset in the hyperperiod the thread is dispatched at
+	os_pthread pthread;  ///< Thread function of the thread to dispatch (NULL for the Idle thread)
+} os_cyclic_entry;
+
+/*! \struct os_sched_ops
+    Scheduling policy operations, all called with the kernel in a critical section.
+*/
+typedef struct os_sched_ops
+{
+	void (*enqueue)(osThreadId thread_id);                          ///< Make a thread ready to run (\ref TH_READY unless running), no effect if already ready
+	void (*dequeue)(osThreadId thread_id, osThreadStatus status);   ///< Take a thread out of the ready threads and set its new state
+	void (*pick_next)(void);                                         ///< Select the thread to run: set \ref th_q_h, the thread states and next_task (the Idle thread when nothing is ready)
+	void (*tick)(void);                                              ///< Charge a system tick to the running thread, before \ref os_sched_ops::pick_next
+	void (*set_priority)(osThreadId thread_id, osPriority priority); ///< Change the priority of a thread, ready or not
+	void (*yield)(osThreadId thread_id);                             ///< Let the other ready threads go before the thread
+} os_sched_ops;
+
+/*! \struct os_partition_window
+    Partition window of the major frame.
+*/
+typedef struct os_partition_window
+{
+	uint32_t partition;  ///< Partition owning the window
+	uint32_t ticks;      ///< Length of the window in ticks
+} os_partition_window;
+
+/*! \def OS_PRIORITY_LEVELS
+         Number of thread priority levels, from \ref osPriorityIdle to \ref osPriorityRealtime. */
+#define OS_PRIORITY_LEVELS ((uint32_t) (osPriorityRealtime - osPriorityIdle + 1))
+
+/*! \def OS_NO_Q
+         Queue index of a thread that is not linked in the Ready-to-Run queue. */
+#define OS_NO_Q            OS_PRIORITY_LEVELS
+
+/*! \def os_PriorityLevel(priority)
+         Maps a thread priority to its Ready-to-Run queue level (0 for \ref osPriorityIdle). */
+#define os_PriorityLevel(priority) ((uint32_t) ((priority) - osPriorityIdle))
+
 void scheduler(void);
+void os_RoundRobinTick(void);
+#if (OS_PARTITIONS > 1)
+void os_PartitionTick(void);
+uint32_t os_PartitionNext(void);
+#else
+#define os_PartitionTick()
+#endif
+#if ((OS_AGING) && (OS_AGING == 1))
+void os_AgingTick(void);
+#else
+#define os_AgingTick()
+#endif
+void os_CyclicStart(void);
+void os_CyclicTick(void);
+void os_CyclicYield(void);
+uint32_t os_CyclicNext(void);
+void os_BudgetTick(void);
+void os_BudgetQInsert (osThreadId thread_id);
+void os_BudgetQRemove (osThreadId thread_id);
+
+void os_ReadyQInsert (osThreadId thread_id);
+void os_ReadyQRemove (osThreadId thread_id, osThreadStatus status);
+void os_ReadyQSetPriority (osThreadId thread_id, osPriority priority);
+void os_ReadyQYield (osThreadId thread_id);
+
+/*! \def os_SchedEnqueue(thread_id)
+         Scheduling policy operation, see \ref os_sched_ops. The built-in policy is resolved at compile time. */
+#if (OS_SCHED_POLICY == 0)
+#define os_SchedEnqueue(thread_id)               os_ReadyQInsert(thread_id)
+#define os_SchedDequeue(thread_id, status)       os_ReadyQRemove((thread_id), (status))
+#define os_SchedPickNext()                       scheduler()
+#define os_SchedTick()                           do { os_PartitionTick(); os_BudgetTick(); os_AgingTick(); os_RoundRobinTick(); } while (0)
+#define os_SchedSetPriority(thread_id, priority) os_ReadyQSetPriority((thread_id), (priority))
+#define os_SchedYield(thread_id)                 os_ReadyQYield(thread_id)
+#else
+extern const os_sched_ops OS_SCHED_OPS;
+#define os_SchedEnqueue(thread_id)               (OS_SCHED_OPS.enqueue(thread_id))
+#define os_SchedDequeue(thread_id, status)       (OS_SCHED_OPS.dequeue((thread_id), (status)))
+#define os_SchedPickNext()                       (OS_SCHED_OPS.pick_next())
+#define os_SchedTick()                           (OS_SCHED_OPS.tick())
+#define os_SchedSetPriority(thread_id, priority) (OS_SCHED_OPS.set_priority((thread_id), (priority)))
+#define os_SchedYield(thread_id)                 (OS_SCHED_OPS.yield(thread_id))
+#endif
 
 #endif //_SCHEDULER_H
@@ -23,6 +23,9 @@
 //              <9=> 8
 //              <10=> 9
 //              <11=> 10
+//              <16=> 15
+//              <32=> 31
+//              <64=> 63
 //          <i> Specifies the maximum number of threads supported
 //
 #define MAX_THREADS 7         ///< Maximum number of threads supported
@@ -41,6 +44,87 @@
 //          <i> Specifies the Default Stack Size for a given Thread
 //
 #define DEFAULT_STACK_SIZE 200 ///< Default Stack Size for a given Thread
+//
+//      <o> Default Round-Robin Time Slice (Ticks) <0-1000>
+//          <i> Time slice given to a thread defined with osThreadDef before the next ready thread of the same priority runs.
+//          <i> 0 disables round-robin: a thread runs until it blocks or yields. Use osThreadDefRR to set it per thread.
+//
+#define OS_ROBIN_QUANTUM 5 ///< Default round-robin time slice in ticks (0 = no time slicing)
+//
+//      <o> EDF Thread Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Priority level of the threads defined with osThreadDefEDF. Within this level the thread with the earliest deadline runs first.
+//          <i> Fixed-priority threads above this level preempt the EDF threads, the ones below run in the EDF slack time.
+//
+#define OS_EDF_PRIORITY 0 ///< EDF threads priority level (\ref osPriorityNormal)
+//
+//      <o> Rate-Monotonic Highest Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Priority level given to the rate-monotonic threads (osThreadDefRM) with the shortest period.
+//
+#define OS_RM_PRIORITY_MAX 2 ///< Highest priority level of the rate-monotonic threads (\ref osPriorityHigh)
+//
+//      <o> Rate-Monotonic Lowest Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Each longer period gets the next lower level down to this one, the longest periods share it.
+//          <i> Keep the band clear of the EDF priority level.
+//
+#define OS_RM_PRIORITY_MIN 1 ///< Lowest priority level of the rate-monotonic threads (\ref osPriorityAboveNormal)
+//
+//      <o> Budget Exhausted Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Priority a thread defined with osThreadDefBudget drops to once its execution budget is used up, until the budget is replenished.
+//          <i> Kept above osPriorityIdle so the demoted thread still gets the time the Idle thread would have.
+//
+#define OS_BUDGET_PRIORITY -2 ///< Priority of the threads that used up their execution budget (\ref osPriorityLow)
+//
+//  <e> Priority Aging
+//          <i> A ready thread that does not get to run for a whole aging period goes up one priority level, up to the aging limit.
+//          <i> It drops back to its priority as soon as it runs. Keeps background threads such as the trace consumer alive under load.
+//          <i> Threads at osPriorityIdle, such as the Idle thread, never age.
+//
+#define OS_AGING 0 ///< priority aging flag: 1 = waiting ready threads age; 0 = no aging
+//
+//    <o> Aging Period (Ticks) <1-100000>
+//          <i> Ticks a ready thread waits before going up one priority level.
+//
+#define OS_AGING_PERIOD 100 ///< Aging period in ticks
+//
+//    <o> Aging Limit
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Highest priority a thread can age to. The threads at or above it never age.
+//
+#define OS_AGING_PRIORITY 0 ///< Highest priority reached by aging (\ref osPriorityNormal)
+//  </e>
 
 typedef enum os_thread_status ///< Thread Status : Running, Blocked or Asleep.
 {
@@ -51,5 +135,12 @@ typedef enum os_thread_status ///< Thread Status : Running, Blocked or Asleep.
 	TH_DEAD             ///< Thread "Dead" state, the process has been terminated
 } osThreadStatus;
 
+typedef enum os_thread_class ///< Thread Scheduling Class : Fixed-priority, EDF or Rate-Monotonic.
+{
+	TH_CLASS_FIXED,     ///< Fixed-priority thread, the priority is set by the thread definition or \ref osThreadSetPriority
+	TH_CLASS_EDF,       ///< Periodic thread run earliest deadline first within \ref OS_EDF_PRIORITY
+	TH_CLASS_RM         ///< Periodic thread with a rate-monotonic priority assigned by the kernel
+} osThreadClass;
+
 #endif // _THREADS_H
 
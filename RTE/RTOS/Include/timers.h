@@ -0,0 +1,48 @@
+/*! \file timers.h
+    \brief This header file defines all timer related data
+		\details Defines the maximum number of timers, how the timer call back functions are dispatched and the timer thread.
+*/
+
+#ifndef _TIMERS_H
+#define _TIMERS_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Timer Configuration ----------------------------------
+//
+//      <o> Number of Timers <1-32>
+//          <i> Specifies the maximum number of timers that can be created.
+//
+#define MAX_TIMERS 8 ///< The maximum number of timers supported
+//
+//  <e> Dispatch Timer Call Backs from the SysTick Interrupt
+//          <i> Run the timer call back functions directly from SysTick_Handler instead of the timer thread.
+//          <i> Only for very short call backs that do not call blocking functions. No timer thread is created.
+//
+#define OS_TIMER_ISR_DISPATCH 0 ///< timer dispatch flag: 1 = call backs run in SysTick_Handler; 0 = call backs run in the timer thread
+//  </e>
+//
+//      <o> Timer Thread Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Priority of the thread running the timer call back functions.
+//
+#define OS_TIMER_PRIORITY 3 ///< Timer thread priority (\ref osPriorityRealtime)
+
+#if (OS_TIMER_ISR_DISPATCH == 0)
+extern void threadTimer (void const *argument);
+int Init_threadTimer (void);
+extern osThreadId tid_threadTimer;
+#endif
+
+void os_TimerTick (void);
+uint32_t os_TimerQNext (void);
+
+#endif // _TIMERS_H
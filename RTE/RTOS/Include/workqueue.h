@@ -0,0 +1,71 @@
+/*! \file workqueue.h
+    \brief This header file defines the interrupt work queue
+		\details Defines the size of the work queue, the priority of the worker thread and the interface the interrupt handlers
+		         use to hand their processing over to the worker thread.
+*/
+
+#ifndef _WORKQUEUE_H
+#define _WORKQUEUE_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+
+//-------- <<< Use Configuration Wizard in Context Menu >>> ------------------
+//--------------------- Work Queue Configuration ----------------------------------
+//
+//  <e> Interrupt Work Queue
+//          <i> Interrupt handlers queue work items with osWorkSubmit, the worker thread runs them in queue order.
+//          <i> The worker thread takes one thread slot (MAX_THREADS).
+//
+#define ENABLE_WORK_QUEUE 1 ///< work queue flag: 1 = create the work queue and the worker thread; 0 = no work queue
+//
+//      <o> Work Queue Size
+//              <4=> 4
+//              <8=> 8
+//              <16=> 16
+//              <32=> 32
+//              <64=> 64
+//          <i> Specifies the number of work items that can wait for the worker thread, a power of 2.
+//
+#define OS_WORK_QUEUE_SIZE 16 ///< Number of work items that can wait for the worker thread (power of 2)
+//
+//      <o> Worker Thread Priority
+//              <-3=> osPriorityIdle
+//              <-2=> osPriorityLow
+//              <-1=> osPriorityBelowNormal
+//              <0=> osPriorityNormal
+//              <1=> osPriorityAboveNormal
+//              <2=> osPriorityHigh
+//              <3=> osPriorityRealtime
+//          <i> Priority of the thread running the work items.
+//
+#define OS_WORK_PRIORITY 2 ///< Worker thread priority (\ref osPriorityHigh)
+//  </e>
+
+#if ((OS_WORK_QUEUE_SIZE & (OS_WORK_QUEUE_SIZE - 1)) != 0)
+#error "OS_WORK_QUEUE_SIZE must be a power of 2"
+#endif
+
+/// Work item function, called by the worker thread with the data captured by the interrupt handler.
+typedef void (*os_pwork) (uint32_t data);
+
+#if ((ENABLE_WORK_QUEUE) && (ENABLE_WORK_QUEUE == 1))
+/*! \struct os_work_item
+    Work item waiting for the worker thread.
+*/
+typedef struct os_work_item
+{
+	os_pwork          pwork;  ///< work item function
+	uint32_t          data;   ///< data passed to the work item function
+	volatile uint32_t ready;  ///< set once the item is written, cleared when the worker thread takes it
+} os_work_item;
+
+extern void threadWork (void const *argument);
+int Init_threadWork (void);
+extern osThreadId tid_threadWork;
+extern uint32_t work_q_lost;
+
+osStatus osWorkSubmit (os_pwork pwork, uint32_t data);
+#endif
+
+#endif // _WORKQUEUE_H
@@ -0,0 +1,251 @@
+/*! \file benchmark.c
+    \brief Kernel benchmark.
+		\details Fills the thread queue with filler threads. The fillers are ready to run at idle priority,
+		         so they are seen by the scheduler on every tick but are never selected to run.
+		         Build with different \ref MAX_THREADS values (7 to 64) and compare
+		         kernel_stats.systick_cycles_max in the debugger watch window: the \ref SysTick_Handler
+		         cost is expected to stay flat since picking the next thread no longer depends on the number of threads.
+		         No figures have been recorded yet, this is the claim to check on the target.
+
+		         The mutex benchmark plays out a priority inversion: benchLow holds the mutex for \ref BENCH_HOLD_TICKS,
+		         benchMedium wakes up in the meantime and keeps the processor busy for \ref BENCH_BUSY_TICKS, and benchHigh
+		         waits on the mutex. bench_stats.mutex_block_cycles_max should be about \ref BENCH_HOLD_TICKS with OS_MUTEX_INHERITANCE
+		         (benchLow runs at the priority of benchHigh), and grow by \ref BENCH_BUSY_TICKS without it.
+		         Not measured on the target yet.
+
+		         The preemption threshold benchmark runs three threads of the same priority, each working for 
+		         \ref BENCH_BUSY_TICKS and then yielding. With \ref BENCH_PT_THRESHOLD the threads are not time sliced
+		         and should switch once per round; compare kernel_stats.pendsv_cnt / bench_stats.pt_rounds with and without it.
+		         Not measured on the target yet.
+
+		         The yield benchmark times osThreadYield from a thread alone at its priority, so the yield comes back
+		         to the same thread: bench_stats.yield_cycles_min is the round trip through the kernel, with or without
+		         the SVC exception depending on \ref ENABLE_FAST_YIELD.
+*/
+
+#include "CU_TM4C123.h"
+#include "osObjects.h"
+#include "benchmark.h"
+
+/*! \def BENCH_HOLD_TICKS
+         Ticks benchLow keeps the mutex busy. */
+#define BENCH_HOLD_TICKS 5
+/*! \def BENCH_BUSY_TICKS
+         Ticks benchMedium keeps the processor busy. */
+#define BENCH_BUSY_TICKS 20
+/*! \def BENCH_PT_THRESHOLD
+         Preemption threshold of the cooperating threads, osPriorityError to run them time sliced instead. */
+#define BENCH_PT_THRESHOLD osPriorityNormal
+/*! \def BENCH_YIELD_LOOPS
+         Yields measured in a row by benchYield. */
+#define BENCH_YIELD_LOOPS 100
+
+os_bench_stats bench_stats;         ///< Benchmark measurements
+
+#if (BENCHMARK_FILLERS == 1)
+void benchFiller (void const *argument);
+
+osThreadDef (benchFiller, osPriorityIdle, MAX_THREADS, 100);  ///< thread definition
+#endif
+
+#if ((BENCHMARK_MUTEX == 1) || (BENCHMARK_THRESHOLD == 1))
+void benchBusy (uint32_t ticks);
+#endif
+
+#if (BENCHMARK_MUTEX == 1)
+void benchLow (void const *argument);
+void benchMedium (void const *argument);
+void benchHigh (void const *argument);
+
+osThreadDef (benchLow, osPriorityLow, 1, 100);        ///< thread definition
+osThreadDef (benchMedium, osPriorityNormal, 1, 100);  ///< thread definition
+osThreadDef (benchHigh, osPriorityHigh, 1, 100);      ///< thread definition
+osMutexDef (benchMutex);                              ///< mutex definition
+osMutexId mid_benchMutex;                             ///< mutex id
+#endif
+
+#if (BENCHMARK_THRESHOLD == 1)
+void benchCoop (void const *argument);
+
+osThreadDefPT (benchCoop, osPriorityBelowNormal, 3, 100, BENCH_PT_THRESHOLD);  ///< thread definition
+#endif
+
+#if (BENCHMARK_YIELD == 1)
+void benchYield (void const *argument);
+
+osThreadDef (benchYield, osPriorityRealtime, 1, 100);  ///< thread definition
+#endif
+
+/*!
+    \brief Initializing the benchmark threads
+		\details Must be called after all the other threads are created, the filler threads take every free slot of the thread queue.
+		\return 0=successful; -1=failure
+*/
+int Init_benchmark (void)
+{
+	uint32_t created = 0;
+
+#if (BENCHMARK_MUTEX == 1)
+	mid_benchMutex = osMutexCreate (osMutex(benchMutex));
+	if (mid_benchMutex == NULL) return(-1);
+	if (osThreadCreate (osThread(benchLow), NULL) == NULL) return(-1);
+	if (osThreadCreate (osThread(benchMedium), NULL) == NULL) return(-1);
+	if (osThreadCreate (osThread(benchHigh), NULL) == NULL) return(-1);
+	created += 3;
+#endif
+
+#if (BENCHMARK_THRESHOLD == 1)
+	if (osThreadCreate (osThread(benchCoop), NULL) == NULL) return(-1);
+	if (osThreadCreate (osThread(benchCoop), NULL) == NULL) return(-1);
+	if (osThreadCreate (osThread(benchCoop), NULL) == NULL) return(-1);
+	created += 3;
+#endif
+
+#if (BENCHMARK_FILLERS == 1)
+	while (osThreadCreate (osThread(benchFiller), NULL) != NULL)
+	{
+		created++;
+	}
+#endif
+
+	if (created == 0)
+	{
+		return(-1);
+	}
+
+  return(0);
+}
+
+#if (BENCHMARK_FILLERS == 1)
+/*!
+    \brief Thread definition for the benchmark filler threads.
+    \param argument A pointer to the list of arguments.
+*/
+void benchFiller (void const *argument)
+{
+  while (1)
+	{
+		osThreadYield();  // never selected while the Idle thread is around
+  }
+}
+#endif
+
+#if ((BENCHMARK_MUTEX == 1) || (BENCHMARK_THRESHOLD == 1))
+/*!
+    \brief Keep the processor busy for a number of ticks.
+    \param ticks Number of ticks
+*/
+void benchBusy (uint32_t ticks)
+{
+	uint32_t start = osKernelSysTick();
+
+	while ((osKernelSysTick() - start) < ticks)
+	{
+	}
+}
+#endif
+
+#if (BENCHMARK_MUTEX == 1)
+/*!
+    \brief Thread definition for the low priority thread of the mutex benchmark, holding the mutex.
+    \param argument A pointer to the list of arguments.
+*/
+void benchLow (void const *argument)
+{
+  while (1)
+	{
+		if (osMutexWait (mid_benchMutex, osWaitForever) == osOK)
+		{
+			benchBusy(BENCH_HOLD_TICKS);
+			osMutexRelease (mid_benchMutex);
+		}
+		osDelay(3);
+  }
+}
+
+/*!
+    \brief Thread definition for the medium priority thread of the mutex benchmark, not using the mutex.
+    \param argument A pointer to the list of arguments.
+*/
+void benchMedium (void const *argument)
+{
+  while (1)
+	{
+		osDelay(7);
+		benchBusy(BENCH_BUSY_TICKS);
+  }
+}
+
+/*!
+    \brief Thread definition for the high priority thread of the mutex benchmark, measuring its blocking time.
+    \param argument A pointer to the list of arguments.
+*/
+void benchHigh (void const *argument)
+{
+	uint32_t cycles;
+
+  while (1)
+	{
+		osDelay(10);
+		cycles = DWT->CYCCNT;
+		if (osMutexWait (mid_benchMutex, osWaitForever) == osOK)
+		{
+			cycles = DWT->CYCCNT - cycles;
+			osMutexRelease (mid_benchMutex);
+
+			bench_stats.mutex_block_cnt++;
+			bench_stats.mutex_block_cycles = cycles;
+			if (cycles > bench_stats.mutex_block_cycles_max)
+			{
+				bench_stats.mutex_block_cycles_max = cycles;
+			}
+		}
+  }
+}
+#endif
+
+#if (BENCHMARK_THRESHOLD == 1)
+/*!
+    \brief Thread definition for the cooperating threads of the preemption threshold benchmark.
+    \param argument A pointer to the list of arguments.
+*/
+void benchCoop (void const *argument)
+{
+  while (1)
+	{
+		benchBusy(BENCH_BUSY_TICKS);
+		bench_stats.pt_rounds++;
+		osThreadYield();  // hand over to the next cooperating thread
+  }
+}
+#endif
+
+#if (BENCHMARK_YIELD == 1)
+/*!
+    \brief Thread definition for the yield benchmark, measuring the yield round trip.
+    \param argument A pointer to the list of arguments.
+*/
+void benchYield (void const *argument)
+{
+	uint32_t cycles, i;
+
+	bench_stats.yield_cycles_min = 0xFFFFFFFF;
+  while (1)
+	{
+		for (i = 0; i < BENCH_YIELD_LOOPS; i++)
+		{
+			cycles = DWT->CYCCNT;
+			osThreadYield();  // no other thread at this priority, back right away
+			cycles = DWT->CYCCNT - cycles;
+
+			bench_stats.yield_cnt++;
+			bench_stats.yield_cycles = cycles;
+			if (cycles < bench_stats.yield_cycles_min)
+			{
+				bench_stats.yield_cycles_min = cycles;
+			}
+		}
+		osDelay(10);  // leave the processor to the other threads
+  }
+}
+#endif
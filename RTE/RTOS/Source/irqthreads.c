@@ -0,0 +1,312 @@
+/// \file irqthreads.c
+/// \brief Threaded interrupt handler implementation
+/// \details An interrupt source is bound to a thread. Its vector runs \ref os_IrqHandler, which only masks the source
+///          and makes the thread ready: the interrupt is then handled at the priority of the thread, under the
+///          control of the scheduler, and the thread lets the source in again once done.
+
+#include "CU_TM4C123.h"
+#include "cmsis_os.h"
+#include "osObjects.h"
+#include "kernel.h"
+#include "scheduler.h"
+#include "irqthreads.h"
+
+#if ((ENABLE_IRQ_THREADS) && (ENABLE_IRQ_THREADS == 1))
+
+/*! \def OS_IRQ_VECTORS
+         Number of entries of the vector table in startup_TM4C123.s (16 system exceptions and 139 interrupts). */
+#define OS_IRQ_VECTORS (16 + 139)
+
+extern uint32_t __Vectors[];        ///< Vector table in flash (startup_TM4C123.s)
+
+/// Vector table in RAM, aligned on the table size rounded up to a power of 2 as VTOR requires
+uint32_t irq_vectors[OS_IRQ_VECTORS] __attribute__((aligned(1024)));
+
+os_irq_thread irq_threads[OS_IRQ_THREADS];  ///< Interrupt sources bound to threads
+
+// Prototypes
+os_irq_thread *os_IrqFind (osThreadId thread_id, int32_t irqn);
+void os_IrqVectorInit (void);
+void os_IrqUnbind (os_irq_thread *irq);
+
+/// Bind an interrupt source to the running thread.
+/// \details The vector of the source is replaced with \ref os_IrqHandler and the source stays masked until the thread
+///          calls \ref osIrqWait. A source above \ref OS_SYSCALL_PRIORITY is brought down to the ceiling.
+/// \param[in]     irqn          interrupt number (IRQn_Type) of the source.
+/// \return status code that indicates the execution status of the function.
+/// \note RavenOS specific extension, not to be called from interrupt service routines.
+osStatus osIrqAttach (int32_t irqn)
+{
+	osThreadId thread_id = osThreadGetId();
+	os_irq_thread *irq;
+
+	if (__get_IPSR() != 0)
+	{
+		return osErrorISR;
+	}
+
+	if ((irqn < 0) || (irqn >= (OS_IRQ_VECTORS - 16)))
+	{
+		return osErrorParameter;
+	}
+
+	os_KernelEnterCriticalSection();
+	if ((os_IrqFind(thread_id, -1) != NULL) || (os_IrqFind(NULL, irqn) != NULL))
+	{
+		// one interrupt source per thread and one thread per interrupt source
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+
+	if ((irq = os_IrqFind(NULL, -1)) == NULL)
+	{
+		// no room left
+		os_KernelExitCriticalSection();
+		return osErrorNoMemory;
+	}
+
+	NVIC_DisableIRQ((IRQn_Type) irqn);
+	os_IrqVectorInit();
+	irq_vectors[16 + irqn] = (uint32_t) os_IrqHandler;
+	if (NVIC_GetPriority((IRQn_Type) irqn) < OS_SYSCALL_PRIORITY)
+	{
+		// the handler uses the kernel
+		NVIC_SetPriority((IRQn_Type) irqn, OS_SYSCALL_PRIORITY);
+	}
+
+	irq->thread_id = thread_id;
+	irq->irqn      = irqn;
+	irq->pending   = 0;
+	irq->masked    = 1;
+	irq->wait      = 0;
+	os_KernelExitCriticalSection();
+
+	return osOK;
+}
+
+/// Let the interrupt source of the running thread in again and wait for its next interrupt.
+/// \details An interrupt already taken while the thread was busy returns right away, the source is masked again
+///          in any case once the interrupt fires.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return \ref osOK when the interrupt fired, \ref osEventTimeout when it did not in time, or an error code.
+/// \note RavenOS specific extension, not to be called from interrupt service routines.
+osStatus osIrqWait (uint32_t millisec)
+{
+	uint64_t microsec = ((uint64_t) millisec) * 1000;
+	uint32_t ticks;
+	osThreadId curr_th = osThreadGetId();
+	os_irq_thread *irq;
+
+	if (__get_IPSR() != 0)
+	{
+		return osErrorISR;
+	}
+
+	os_KernelEnterCriticalSection();
+	if ((irq = os_IrqFind(curr_th, -1)) == NULL)
+	{
+		// no interrupt source bound to this thread
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+
+	if (irq->pending != 0)
+	{
+		// the interrupt fired in the meantime
+		irq->pending = 0;
+		os_KernelExitCriticalSection();
+		return osOK;
+	}
+
+	if (irq->masked != 0)
+	{
+		// done with the last interrupt, drop the request latched while masked and let the source in again
+		irq->masked = 0;
+		NVIC_ClearPendingIRQ((IRQn_Type) irq->irqn);
+		NVIC_EnableIRQ((IRQn_Type) irq->irqn);
+	}
+
+	if (millisec == 0)
+	{
+		os_KernelExitCriticalSection();
+		return osEventTimeout;
+	}
+
+	if (osWaitForever != millisec)
+	{
+		ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
+		if (ticks == 0)
+		{
+			ticks = 1;
+		}
+		// the timeout wakes the thread up if the interrupt does not fire in time
+		if (os_TimedQInsert(curr_th, ticks) != osOK)
+		{
+			os_KernelExitCriticalSection();
+			return osErrorResource;
+		}
+	}
+
+	// os_IrqHandler or the timeout sets the exit status and makes the thread ready again
+	irq->wait = 1;
+	os_ThreadBlock(TH_BLOCKED);
+
+	os_KernelEnterCriticalSection();
+	irq->wait = 0;
+	if (curr_th->timed_ret == osOK)
+	{
+		irq->pending = 0;
+	}
+	os_KernelExitCriticalSection();
+
+	return curr_th->timed_ret;
+}
+
+/// Unbind the interrupt source of the running thread.
+/// \details The source is left masked and its vector goes back to the handler of startup_TM4C123.s.
+/// \return status code that indicates the execution status of the function.
+/// \note RavenOS specific extension, not to be called from interrupt service routines.
+osStatus osIrqDetach (void)
+{
+	os_irq_thread *irq;
+
+	if (__get_IPSR() != 0)
+	{
+		return osErrorISR;
+	}
+
+	os_KernelEnterCriticalSection();
+	if ((irq = os_IrqFind(osThreadGetId(), -1)) == NULL)
+	{
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+	os_IrqUnbind(irq);
+	os_KernelExitCriticalSection();
+
+	return osOK;
+}
+
+/*!
+    \brief Handler of the interrupt sources bound to threads.
+    \details Masks the source and makes its thread ready if it waits in \ref osIrqWait. The interrupt itself is
+             handled by the thread. PendSV switches to the thread once the interrupts return, if it is the thread to run.
+*/
+void os_IrqHandler (void)
+{
+	int32_t irqn = (int32_t) __get_IPSR() - 16;
+	osThreadId thread_id;
+	os_irq_thread *irq;
+	uint32_t woken = 0;
+
+	// masked until the thread is done with it
+	NVIC_DisableIRQ((IRQn_Type) irqn);
+
+	os_KernelEnterCriticalSection();
+	if ((irq = os_IrqFind(NULL, irqn)) == NULL)
+	{
+		// not bound anymore, leave the source masked
+		os_KernelExitCriticalSection();
+		return;
+	}
+
+	irq->masked  = 1;
+	irq->pending = 1;
+	thread_id = irq->thread_id;
+	if ((irq->wait != 0) && (thread_id->timed_ret == osErrorResource))
+	{
+		os_TimedQRemove(thread_id);
+		thread_id->timed_ret = osOK;
+		os_SchedEnqueue(thread_id);
+		woken = 1;
+	}
+	os_KernelExitCriticalSection();
+
+	if (woken != 0)
+	{
+		// Thread(s) status change - invoke scheduler to re-evaluate running thread (only pends PendSV from an interrupt)
+		os_KernelInvokeScheduler ();
+	}
+	return;
+}
+
+/// Unbind the interrupt source of a thread being terminated.
+/// \param[in]     thread_id  thread object.
+void os_IrqRemoveThread (osThreadId thread_id)
+{
+	os_irq_thread *irq;
+
+	os_KernelEnterCriticalSection();
+	if ((irq = os_IrqFind(thread_id, -1)) != NULL)
+	{
+		os_IrqUnbind(irq);
+	}
+	os_KernelExitCriticalSection();
+	return;
+}
+
+/// Search the interrupt sources bound to threads.
+/// \param[in]     thread_id  thread object, NULL to search by interrupt number.
+/// \param[in]     irqn       interrupt number, -1 to search by thread.
+/// \return the entry found, or the first free entry when both thread_id is NULL and irqn is -1. NULL if none.
+/// \note Must be called with the kernel in a critical section.
+os_irq_thread *os_IrqFind (osThreadId thread_id, int32_t irqn)
+{
+	uint32_t i;
+
+	for ( i = 0; i < OS_IRQ_THREADS ; i++ )
+	{
+		if (irq_threads[i].thread_id == NULL)
+		{
+			if ((thread_id == NULL) && (irqn == -1))
+			{
+				return &irq_threads[i];
+			}
+			continue;
+		}
+		if ((irq_threads[i].thread_id == thread_id) || ((thread_id == NULL) && (irq_threads[i].irqn == irqn)))
+		{
+			return &irq_threads[i];
+		}
+	}
+	return NULL;
+}
+
+/// Move the vector table to RAM so vectors can be replaced, on the first call.
+/// \note Must be called with the kernel in a critical section.
+void os_IrqVectorInit (void)
+{
+	uint32_t i;
+
+	if (SCB->VTOR == (uint32_t) irq_vectors)
+	{
+		return;
+	}
+
+	for ( i = 0; i < OS_IRQ_VECTORS ; i++ )
+	{
+		irq_vectors[i] = __Vectors[i];
+	}
+	// the copy is complete before the core uses it
+	__DSB();
+	SCB->VTOR = (uint32_t) irq_vectors;
+	__DSB();
+	return;
+}
+
+/// Mask an interrupt source and give its vector back to startup_TM4C123.s.
+/// \param[in]     irq        entry of the interrupt source.
+/// \note Must be called with the kernel in a critical section.
+void os_IrqUnbind (os_irq_thread *irq)
+{
+	NVIC_DisableIRQ((IRQn_Type) irq->irqn);
+	irq_vectors[16 + irq->irqn] = __Vectors[16 + irq->irqn];
+
+	irq->thread_id = NULL;
+	irq->pending   = 0;
+	irq->masked    = 1;
+	irq->wait      = 0;
+	return;
+}
+
+#endif
@@ -9,6 +9,8 @@
 #include "osObjects.h"                      // RTOS object definitions
 #include "kernel.h"
 #include "scheduler.h"
+#include "timers.h"
+#include "workqueue.h"
 #include "trace.h"
 #include "RTE_Components.h"
 
@@ -18,19 +20,40 @@
 	
 #define os_sysTickTicks 16000  ///< Number of ticks between two system timer interrupts. This would generate 1000 interruts/s on a 16MHz clock.
 #define ENABLE_KERNEL_PRINTF 0 ///< Enables printf traces from kernel. Printf from the kernel may not be protected so use at own risk.
+#define OS_TICKLESS_MAX_TICKS (SysTick_LOAD_RELOAD_Msk / os_sysTickTicks) ///< Longest tickless period the 24-bit SysTick can count (ticks)
+#define OS_TICKLESS_MIN_CYCLES 32 ///< Fewest cycles left to a tick boundary for the SysTick to be reprogrammed to it
+#define OS_KERNEL_BASEPRI (OS_SYSCALL_PRIORITY << (8 - __NVIC_PRIO_BITS)) ///< BASEPRI value masking the interrupts up to \ref OS_SYSCALL_PRIORITY
+#define OS_SVC_COUNT (sizeof(os_svc_table) / sizeof(os_svc_table[0])) ///< Number of SVC services in \ref os_svc_table
+
+#if ((ENABLE_COOPERATIVE == 1) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+#error "The cyclic executive dispatches from the system tick, it cannot be built with ENABLE_COOPERATIVE"
+#endif
 
 void __svc(0x00) os_start(void);              // OS start scheduler
 void __svc(0x01) thread_yield(void);          // Thread needs to schedule a switch of context
 void __svc(0x02) stack_alloc(int thread_idx); // Initialize the process stack pointer PSP_array[thread_idx]
 void SVC_Handler_C(unsigned int * svc_args);
+void os_SvcStart(unsigned int * svc_args);
+void os_SvcYield(unsigned int * svc_args);
+void os_SvcStackAlloc(unsigned int * svc_args);
 void HardFault_Handler_C(unsigned int * svc_args);
 void ScheduleContextSwitch(void);
 void os_KernelEnterCriticalSection (void);
 void os_KernelExitCriticalSection (void);
+void os_KernelTicklessEnter (void);
+uint32_t os_KernelTicklessExit (uint32_t expired);
+uint32_t os_KernelLocked (void);
+void os_KernelReschedule (void);
+
+/// SVC service, called with the stacked registers of the caller
+typedef void (*os_svc_handler)(unsigned int * svc_args);
 
 /// \var systick_count Event to tasks
 volatile uint32_t systick_count=0;
 
+uint32_t tickless_ticks  = 1;       ///< Number of ticks covered by the SysTick period being counted
+uint32_t tickless_reload = 0;       ///< Tickless state: 0 = tick period; 1 = stretched period armed for the next reload; 2 = stretched period counting
+
 /// Stack for each task ( \ref DEFAULT_STACK_SIZE bytes)
 uint8_t task_stack[MAX_THREADS][DEFAULT_STACK_SIZE];
 
@@ -40,7 +63,14 @@ uint32_t next_task=1;               ///< Next task
 uint32_t PSP_array[MAX_THREADS];    ///< Process Stack Pointer for each task
 uint32_t svc_exc_return;            ///< EXC_RETURN use by SVC
 uint32_t kernel_running = 0;        ///< flag whether the kernel is running or not
-uint32_t kernel_busy = 0;           ///< flag whether the kernel is busy or not
+uint32_t kernel_busy = 0;           ///< Kernel critical section nesting count, the kernel is busy while not 0
+uint32_t kernel_basepri = 0;        ///< BASEPRI value to restore when leaving the outermost critical section
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+uint32_t kernel_crit_start;         ///< Cycle count at the entrance of the outermost critical section
+#endif
+uint32_t kernel_resched = 0;        ///< flag whether a reschedule was deferred by the scheduler lock
+
+os_kernel_stats kernel_stats;       ///< Kernel handler measurements (\ref ENABLE_KERNEL_STATS)
 
 //  ==== Kernel Control Functions ====
 
@@ -61,6 +91,16 @@ osStatus osKernelInitialize (void)
 	//
 	ROM_FPULazyStackingEnable();	
 	
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+	// Enable the DWT cycle counter used to measure the kernel handlers
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	
+	// Kernel handlers run at the priority ceiling: only the interrupts above it can preempt them
+	NVIC_SetPriority(SVCall_IRQn, OS_SYSCALL_PRIORITY);
+	
 	os_KernelExitCriticalSection();	
 	
 	// Initialize the Idle thread
@@ -70,6 +110,22 @@ osStatus osKernelInitialize (void)
 		stop_cpu;
 	}
 	
+#if (OS_TIMER_ISR_DISPATCH == 0)
+	// Initialize the timer thread, running the timer call back functions
+	if (Init_threadTimer() != 0)
+	{
+		stop_cpu;
+	}
+#endif
+	
+#if ((ENABLE_WORK_QUEUE) && (ENABLE_WORK_QUEUE == 1))
+	// Initialize the worker thread, running the work items queued by the interrupt handlers
+	if (Init_threadWork() != 0)
+	{
+		stop_cpu;
+	}
+#endif
+	
 	return osOK;
 }
 
@@ -91,6 +147,51 @@ int32_t osKernelRunning(void)
 	return kernel_running;
 }
 
+/// \brief Lock the scheduler: the running thread is not preempted until the matching \ref osKernelUnlock.
+/// \details Only the lock count of the running thread is changed, interrupts stay enabled.
+/// \return status code that indicates the execution status of the function.
+osStatus osKernelLock (void)
+{
+	osThreadId curr_th = osThreadGetId();
+	
+	if (curr_th == NULL)
+	{
+		return osErrorResource;
+	}
+	
+	curr_th->lock_cnt++;
+	return osOK;
+}
+
+/// \brief Unlock the scheduler locked by \ref osKernelLock.
+/// \details The reschedule deferred while locked runs once the last lock is released.
+/// \return status code that indicates the execution status of the function.
+osStatus osKernelUnlock (void)
+{
+	osThreadId curr_th = osThreadGetId();
+	
+	if ((curr_th == NULL) || (curr_th->lock_cnt == 0))
+	{
+		// not locked
+		return osErrorResource;
+	}
+	
+	curr_th->lock_cnt--;
+	if ((curr_th->lock_cnt == 0) && (kernel_resched != 0))
+	{
+		//invoke scheduler
+		os_KernelInvokeScheduler ();
+	}
+	return osOK;
+}
+
+/// \brief Check whether the running thread holds the scheduler lock.
+/// \return 1 when the scheduling must be deferred, 0 otherwise.
+uint32_t os_KernelLocked (void)
+{
+	return ((th_q[th_q_h]->lock_cnt != 0) && (th_q[th_q_h]->status == TH_RUNNING)) ? 1 : 0;
+}
+
 #if (defined (osFeature_SysTick)  &&  (osFeature_SysTick != 0))     // System Timer available
 
 /// \brief Get the RTOS kernel system timer counter 
@@ -104,40 +205,109 @@ uint32_t osKernelSysTick (void)
 #endif    // System Timer available
 
 /// \brief Mark the entrance to a critical section (for interrupt-handling)
-/// \details Kernel is marked as busy and interrupts (apart from NMI and fault handler) disabled.
-///          This could be defined as a macro to avoid function overhead
+/// \details Kernel is marked as busy and the interrupts up to \ref OS_SYSCALL_PRIORITY are masked with BASEPRI,
+///          the interrupts above the ceiling keep running. The critical sections nest.
+/// \note The SVC exception is masked as well: no SVC call inside a critical section (\ref os_KernelInvokeScheduler only
+///       with \ref ENABLE_FAST_YIELD).
 void os_KernelEnterCriticalSection (void)
 {
+	uint32_t basepri = __get_BASEPRI();
+	
+	// masking the interrupts that can use the kernel
+	__set_BASEPRI(OS_KERNEL_BASEPRI);
+	if (kernel_busy == 0)
+	{
+		kernel_basepri = basepri;
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+		kernel_crit_start = DWT->CYCCNT;
+#endif
+	}
 	// marking kernel as busy
-	kernel_busy = 1;
-	// Disabling interrupts so that the kernel can do any initialization work
-	__disable_irq();
+	kernel_busy++;
   return ;
 }
 
 /// \brief Mark the exit from a critical section (for interrupt-handling)
-/// \details Kernel is marked as normal and interrupts enabled.
-///          This could be defined as a macro to avoid function overhead
+/// \details Leaving the outermost critical section marks the kernel as normal and puts back the interrupt mask
+///          found at its entrance.
 void os_KernelExitCriticalSection (void)
 {
-	// marking kernel as normal
-	kernel_busy = 0;
-	// Any pending interrupts can go now.
-	__enable_irq();
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+	uint32_t cycles;
+#endif
+	
+	if (kernel_busy == 0) // this should not happen
+	{
+		return;
+	}
+	
+	kernel_busy--;
+	if (kernel_busy == 0)
+	{
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+		cycles = DWT->CYCCNT - kernel_crit_start;
+		if (cycles > kernel_stats.crit_cycles_max)
+		{
+			kernel_stats.crit_cycles_max = cycles;
+		}
+#endif
+		// marking kernel as normal, any pending interrupts can go now
+		__set_BASEPRI(kernel_basepri);
+	}
   return ;
 }
 
-/// \brief Perform an SVC call to invoke scheduler.
+/// \brief Invoke the scheduler.
+/// \details With \ref ENABLE_FAST_YIELD the privileged threads run the scheduler directly and only pend PendSV,
+///          the context switch takes place as soon as the critical section is left. Otherwise a thread performs an SVC call.
+///          From an interrupt handler (at or below \ref OS_SYSCALL_PRIORITY) there is no SVC call either: PendSV
+///          switches the context once the interrupts return.
+///          With \ref ENABLE_COOPERATIVE the threads woken up by an interrupt run at the next yield of the running thread.
+///          Inside a critical section the SVC exception is masked and would escalate to HardFault, the scheduler runs directly.
+/// \note Called inside a critical section, the context switch is held back until the outermost critical section is left.
 void os_KernelInvokeScheduler (void)
 {
+	if (__get_IPSR() != 0)
+	{
+#if ((ENABLE_COOPERATIVE) && (ENABLE_COOPERATIVE == 1))
+		// No preemption from interrupts
+#else
+		// Handler mode, an SVC would escalate to HardFault
+		os_KernelEnterCriticalSection();
+		os_KernelReschedule();
+		os_KernelExitCriticalSection();
+#endif
+		return ;
+	}
+#if ((ENABLE_FAST_YIELD) && (ENABLE_FAST_YIELD == 1))
+	os_KernelEnterCriticalSection();
+	os_KernelReschedule();
+	os_KernelExitCriticalSection();
+	// PendSV, if pended, is taken here
+	__ISB();
+#else
+	if (kernel_busy != 0)
+	{
+		// SVC masked by the critical section, PendSV switches the context once it is left
+		os_KernelReschedule();
+		return ;
+	}
 	thread_yield();
+#endif
   return ;
 }
 
 /// \brief Perform an SVC call to allocate stack for a thread
+/// \details Inside a critical section or from an interrupt handler, where the SVC exception would escalate to HardFault,
+///          the stack frame is created directly.
 /// \param thread_idx The thread index in the PSP table to initialize
 void os_KernelStackAlloc (uint32_t thread_idx)
 {
+	if ((kernel_busy != 0) || (__get_IPSR() != 0))
+	{
+		os_SvcStackAlloc((unsigned int *) &thread_idx);
+		return ;
+	}
 	stack_alloc(thread_idx);
   return ;
 }
@@ -147,107 +317,143 @@ void os_KernelStackAlloc (uint32_t thread_idx)
     \brief SVC exception handler
     \details Extracts the stack frame location, saves the current EXC_RETURN, 
     runs the C part of the handler, and restores the new EXC_RETURN.
+    The interrupts up to the ceiling are masked meanwhile, the interrupt mask of the caller is put back on return.
 */
 __asm void SVC_Handler(void)
 {
-	CPSID  I        // Set PRIMASK  (Disable Interrupts)
   TST    LR, #4   // Extract stack frame location
   ITE    EQ
   MRSEQ  R0, MSP
   MRSNE  R0, PSP
+	MRS    R2, BASEPRI
+	PUSH   {R2, R3}    // Save the interrupt mask of the caller (8-byte aligned stack)
+	MOV    R1, #__cpp(OS_KERNEL_BASEPRI)
+	MSR    BASEPRI, R1 // Mask the interrupts up to the syscall priority ceiling
   LDR    R1,=__cpp(&svc_exc_return) // Save current EXC_RETURN
   STR    LR,[R1]	
   BL     __cpp(SVC_Handler_C)       // Run C part of SVC_Handler
   LDR    R1,=__cpp(&svc_exc_return) // Load new EXC_RETURN
   LDR    LR,[R1]
-	CPSIE  I        // Clear PRIMASK  (Enable Interrupts)
+	POP    {R2, R3}
+	MSR    BASEPRI, R2 // Put back the interrupt mask of the caller
   BX     LR
   ALIGN  4
 }
 
+/*! 
+    \brief SVC 0: initializing the OS and starting the scheduler.
+    \param svc_args Stacked registers of the caller
+*/
+void os_SvcStart(unsigned int * svc_args)
+{
+	uint32_t i;
+	
+	// Starting the task scheduler
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+	// Dispatch the first entries of the schedule table
+	os_CyclicStart();
+#else
+	// Update thread to be run based on priority
+	os_SchedPickNext();
+#endif
+	curr_task = next_task; // Switch to head ready-to-run task (Current task)		
+	th_q_h = curr_task;
+	th_q[curr_task]->status = TH_RUNNING;
+	if (PSP_array[curr_task] == NULL)
+	{
+		// Stack not allocated for current task, allocating
+		i = curr_task;
+		th_q[i]->stack_p = (uint32_t) task_stack[i];
+		PSP_array[i] = ((unsigned int) th_q[i]->stack_p) + (th_q[i]->stack_size) - 18*4;
+		HW32_REG((PSP_array[i] + (16<<2))) = (unsigned long) th_q[i]->start_p; // initial Program Counter
+		HW32_REG((PSP_array[i] + (17<<2))) = 0x01000000;            // initial xPSR
+		HW32_REG((PSP_array[i]          )) = 0xFFFFFFFDUL;          // initial EXC_RETURN
+		HW32_REG((PSP_array[i] + ( 1<<2))) = 0x2;// initial CONTROL : privileged (BASEPRI access), PSP	
+		
+		th_q[i]->stack_p = PSP_array[i];				
+	}
+
+	svc_exc_return = HW32_REG((PSP_array[curr_task])); // Return to thread with PSP
+	__set_PSP((PSP_array[curr_task] + 10*4));  // Set PSP to @R0 of task 0 exception stack frame
+
+	NVIC_SetPriority(PendSV_IRQn, 0xFF);       // Set PendSV to lowest possible priority
+	if (SysTick_Config(os_sysTickTicks) != 0)  // 1000 Hz SysTick interrupt on 16MHz core clock
+	{
+		stop_cpu2;
+		// Impossible SysTick_Config number of ticks
+	}
+	__set_CONTROL(0x2);                  // Switch to use Process Stack, privileged state for the BASEPRI critical sections
+	__ISB();       // Execute ISB after changing CONTROL (architectural recommendation)			
+	return;
+}
+
+/*! 
+    \brief SVC 1: thread yield, for a kernel built with \ref ENABLE_FAST_YIELD cleared.
+    \param svc_args Stacked registers of the caller
+*/
+void os_SvcYield(unsigned int * svc_args)
+{
+	os_KernelReschedule();
+	__ISB();       					
+	return;
+}
+
+/*! 
+    \brief SVC 2: creating the stack frame of a thread.
+    \param svc_args Stacked registers of the caller, R0 is the thread index in the PSP table
+*/
+void os_SvcStackAlloc(unsigned int * svc_args)
+{
+	uint32_t i = svc_args[0];  
+
+	th_q[i]->stack_p = (uint32_t) task_stack[i];
+	PSP_array[i] = ((unsigned int) th_q[i]->stack_p) + (th_q[i]->stack_size) - 18*4;
+	HW32_REG((PSP_array[i] + (16<<2))) = (unsigned long) th_q[i]->start_p; // initial Program Counter
+	HW32_REG((PSP_array[i] + (17<<2))) = 0x01000000;            // initial xPSR
+	HW32_REG((PSP_array[i]          )) = 0xFFFFFFFDUL;          // initial EXC_RETURN
+	HW32_REG((PSP_array[i] + ( 1<<2))) = 0x2;// initial CONTROL : privileged (BASEPRI access), PSP		
+	
+	th_q[i]->stack_p = PSP_array[i];
+	__ISB();       			
+	return;
+}
+
+/// SVC services, indexed by SVC number
+const os_svc_handler os_svc_table[] =
+{
+	os_SvcStart,      // 0: OS start
+	os_SvcYield,      // 1: Thread Yield
+	os_SvcStackAlloc  // 2: Stack Allocation
+};
+
 /*! 
     \brief C part of the SVC exception handler
 
-     SVC 0 is initializing the OS and starting the scheduler.
-     Each thread stack frame is initialized.
+     Runs the service of the SVC number from \ref os_svc_table.
      
     \param svc_args Used to extract the SVC number 
 */
 void SVC_Handler_C(unsigned int * svc_args)
 {
-  uint8_t svc_number, i;	
+  uint8_t svc_number;	
   svc_number = ((char *) svc_args[6])[-2]; // Memory[(Stacked PC)-2]
-	// marking kernel as busy
-	kernel_busy = 1;
-  switch(svc_number) {
-    case (0): // OS start		  
- 	    // Starting the task scheduler
-			// Update thread to be run based on priority
-	    scheduler();
-      curr_task = next_task; // Switch to head ready-to-run task (Current task)		
-			th_q_h = curr_task;
-			th_q[curr_task]->status = TH_RUNNING;
-		  if (PSP_array[curr_task] == NULL)
-			{
-				// Stack not allocated for current task, allocating
-				i = curr_task;
-				th_q[i]->stack_p = (uint32_t) task_stack[i];
-				PSP_array[i] = ((unsigned int) th_q[i]->stack_p) + (th_q[i]->stack_size) - 18*4;
-				HW32_REG((PSP_array[i] + (16<<2))) = (unsigned long) th_q[i]->start_p; // initial Program Counter
-				HW32_REG((PSP_array[i] + (17<<2))) = 0x01000000;            // initial xPSR
-				HW32_REG((PSP_array[i]          )) = 0xFFFFFFFDUL;          // initial EXC_RETURN
-				HW32_REG((PSP_array[i] + ( 1<<2))) = 0x3;// initial CONTROL : unprivileged, PSP	
-				
-				th_q[i]->stack_p = PSP_array[i];				
-			}
-
-			svc_exc_return = HW32_REG((PSP_array[curr_task])); // Return to thread with PSP
-			__set_PSP((PSP_array[curr_task] + 10*4));  // Set PSP to @R0 of task 0 exception stack frame
-
-      NVIC_SetPriority(PendSV_IRQn, 0xFF);       // Set PendSV to lowest possible priority
-      if (SysTick_Config(os_sysTickTicks) != 0)  // 1000 Hz SysTick interrupt on 16MHz core clock
-			{
-				stop_cpu2;
-				// Impossible SysTick_Config number of ticks
-			}
-      __set_CONTROL(0x3);                  // Switch to use Process Stack, unprivileged state
-      __ISB();       // Execute ISB after changing CONTROL (architectural recommendation)			
-		  break;
-    case (1): // Thread Yield
-			// Run scheduler to determine if a context switch is needed
-			scheduler();		  
-			if (curr_task != next_task)
-			{ 
-				// Context switching needed
-				ScheduleContextSwitch();
-		  }		
-      __ISB();       					
-			break;
-    case (2): // Stack Allocation
-      // Create stack frame for thread
-		  i = svc_args[0];  
-
-			th_q[i]->stack_p = (uint32_t) task_stack[i];
-			PSP_array[i] = ((unsigned int) th_q[i]->stack_p) + (th_q[i]->stack_size) - 18*4;
-			HW32_REG((PSP_array[i] + (16<<2))) = (unsigned long) th_q[i]->start_p; // initial Program Counter
-			HW32_REG((PSP_array[i] + (17<<2))) = 0x01000000;            // initial xPSR
-			HW32_REG((PSP_array[i]          )) = 0xFFFFFFFDUL;          // initial EXC_RETURN
-			HW32_REG((PSP_array[i] + ( 1<<2))) = 0x3;// initial CONTROL : unprivileged, PSP		
-			
-			th_q[i]->stack_p = PSP_array[i];
-      __ISB();       			
-			break;			
-    default:
+	// marking kernel as busy, SVC_Handler masked the interrupts up to the ceiling
+	kernel_busy++;
+	if (svc_number < OS_SVC_COUNT)
+	{
+		os_svc_table[svc_number](svc_args);
+	}
+	else
+	{
 #if ((ENABLE_KERNEL_PRINTF) && (ENABLE_KERNEL_PRINTF == 1))
-      printf("ERROR: Unknown SVC service number\n\r");
-      printf("- SVC number 0x%x\n\r", svc_number);
+		printf("ERROR: Unknown SVC service number\n\r");
+		printf("- SVC number 0x%x\n\r", svc_number);
 #endif
-      stop_cpu2;
-      break;
-  } // end switch
+		stop_cpu2;
+	}
 	
 	// marking kernel as normal
-	kernel_busy = 0;
+	kernel_busy--;
 }	
 
 // -------------------------------------------------------------------------
@@ -255,11 +461,13 @@ void SVC_Handler_C(unsigned int * svc_args)
     \brief Handles context switch.
 
      Saves the current process context (stack, registers, pointer to stack).
-     Loads the next process context.
+     Loads the next process context. The interrupt mask found at the entrance is put back on return.
 */
 __asm void PendSV_Handler(void)
 { 
-	CPSID    I        // Set PRIMASK  (Disable Interrupts)
+	MRS      R12, BASEPRI // Save the interrupt mask found at the entrance (R12 is not used below)
+	MOV      R0, #__cpp(OS_KERNEL_BASEPRI)
+	MSR      BASEPRI, R0 // Mask the interrupts up to the syscall priority ceiling
   // Save current context
   MRS      R0, PSP     // Get current process stack pointer value
   TST      LR, #0x10   // Test bit 4. If zero, need to stack floating point regs
@@ -285,7 +493,7 @@ __asm void PendSV_Handler(void)
   IT       EQ
   VLDMIAEQ R0!, {S16-S31} // Save floating point registers
   MSR      PSP, R0     // Set PSP to next task
-	CPSIE    I        // Clear PRIMASK  (Enable Interrupts)
+	MSR      BASEPRI, R12 // Put back the interrupt mask found at the entrance
   BX       LR          // Return
   ALIGN  4
 }
@@ -294,23 +502,262 @@ __asm void PendSV_Handler(void)
     \brief Invokes the scheduler
 
      Increment systick counter, invoke scheduler and flag any context switching needed for PendSV to take care of.
+     With \ref ENABLE_COOPERATIVE only the system tick, the thread timeouts and the timers are handled.
 */
 void SysTick_Handler(void) // 1KHz
 {
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+	uint32_t cycles = DWT->CYCCNT;
+#endif
+	
 	os_KernelEnterCriticalSection();
 	// Increment systick counter 
+#if ((ENABLE_TICKLESS_IDLE) && (ENABLE_TICKLESS_IDLE == 1))
+	systick_count += os_KernelTicklessExit(1);
+#else
   systick_count++;
-	// Run scheduler to determine if a context switch is needed
-  scheduler();
+#endif
+	// Wake up the threads whose timeout expired and expire the timers
+	os_TimedQTick();
+	os_TimerTick();
+#if ((ENABLE_COOPERATIVE) && (ENABLE_COOPERATIVE == 1))
+	// No preemption, the threads woken up run at the next yield, blocking call or release
+#else
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+	if (os_KernelLocked() != 0)
+	{
+		// the running thread holds the scheduler lock, dispatch at osKernelUnlock
+		kernel_resched = 1;
+	}
+	else
+	{
+		// Dispatch the thread of the schedule table entry due, no priority decision
+		os_CyclicTick();
+	}
+#else
+	// Charge the tick to the running thread (partition window, execution budget and time slice with the built-in policy)
+	os_SchedTick();
+	if (os_KernelLocked() != 0)
+	{
+		// the running thread holds the scheduler lock, reschedule at osKernelUnlock
+		kernel_resched = 1;
+	}
+	else
+	{
+		// Run scheduler to determine if a context switch is needed
+		os_SchedPickNext();
+	}
+#endif
   if (curr_task != next_task)
 	{ 
 		// Context switching needed
     ScheduleContextSwitch();
   }
+#endif
+#if ((ENABLE_TICKLESS_IDLE) && (ENABLE_TICKLESS_IDLE == 1))
+	// Nothing else to run, no need to tick until the next timeout
+	os_KernelTicklessEnter();
+#endif
 	os_KernelExitCriticalSection();
+	
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+	cycles = DWT->CYCCNT - cycles;
+	kernel_stats.systick_cnt++;
+	kernel_stats.systick_cycles = cycles;
+	if (cycles > kernel_stats.systick_cycles_max)
+	{
+		kernel_stats.systick_cycles_max = cycles;
+	}
+#endif
   return;	
 }
 
+/*! 
+    \brief Stretches the SysTick period up to the next timeout when the Idle thread is the next thread to run.
+    \note   With \ref ENABLE_COOPERATIVE the Idle thread keeps running after a thread woke up, the stretch is undone 
+            by the yield following its WFI.
+    \details Called at the end of \ref SysTick_Handler, right after the SysTick counter reloaded. The counter is never
+             stopped: the stretched reload value is armed and taken by the counter at the end of the tick in progress,
+             so the tick phase does not drift. The SysTick interrupt at the end of that tick starts the stretched period.
+*/
+void os_KernelTicklessEnter (void)
+{
+	uint32_t ticks;
+	
+	if ((next_task != tid_threadIdle->th_q_p) || (tickless_reload != 0))
+	{
+		return;
+	}
+	
+	ticks = os_TimedQNext();
+	if (os_TimerQNext() < ticks)
+	{
+		ticks = os_TimerQNext();
+	}
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+	// wake up for the next entry of the schedule table
+	if (os_CyclicNext() < ticks)
+	{
+		ticks = os_CyclicNext();
+	}
+#elif (OS_PARTITIONS > 1)
+	// wake up for the next partition window, its threads may be ready
+	if (os_PartitionNext() < ticks)
+	{
+		ticks = os_PartitionNext();
+	}
+#endif
+	if (ticks > OS_TICKLESS_MAX_TICKS)
+	{
+		ticks = OS_TICKLESS_MAX_TICKS;
+	}
+	if (ticks <= 2)
+	{
+		// the tick in progress and the next one are counted anyway
+		return;
+	}
+	
+	// the tick in progress ends as usual, the counter reloads the stretched period after it
+	SysTick->LOAD = (ticks - 1) * os_sysTickTicks - 1;
+	
+	tickless_ticks  = ticks - 1;
+	tickless_reload = 1;
+	return;
+}
+
+/*! 
+    \brief Puts back the periodic tick after a stretched SysTick period.
+    \details When woken up early (by a thread or an interrupt other than SysTick), the whole ticks 
+             elapsed so far are accounted and the SysTick is programmed to expire at the next tick boundary.
+             The counter keeps running, the cycles spent reprogramming it are taken off the period so the
+             tick phase is kept to within the few cycles of the stores. Only the kernel critical section is
+             held meanwhile: an interrupt above \ref OS_SYSCALL_PRIORITY taken between the reading of the counter
+             and the stores shifts the tick phase by its duration, it is never delayed.
+    \param expired 1 when called from \ref SysTick_Handler (the programmed period expired), 0 otherwise
+    \return Number of ticks elapsed to add to \ref systick_count
+*/
+uint32_t os_KernelTicklessExit (uint32_t expired)
+{
+	uint32_t val, now, lag, left, elapsed;
+	
+	if (tickless_reload == 0)
+	{
+		// periodic tick running
+		return expired;
+	}
+	
+	// the counter reloads the tick period from its next wrap on
+	SysTick->LOAD = os_sysTickTicks - 1;
+	
+	if (expired != 0)
+	{
+		if (tickless_reload == 1)
+		{
+			// end of the tick in progress at the entrance, the counter just took the stretched period
+			tickless_reload = 2;
+			return 1;
+		}
+		// the whole stretched period elapsed
+		elapsed = tickless_ticks;
+		tickless_ticks  = 1;
+		tickless_reload = 0;
+		return elapsed;
+	}
+	
+	// woken up early
+	val = SysTick->VAL;
+	if (tickless_reload == 1)
+	{
+		if (val <= (os_sysTickTicks - 1))
+		{
+			// still in the tick in progress at the entrance (or its wrap already took the tick period back)
+			tickless_ticks  = 1;
+			tickless_reload = 0;
+			return 0;
+		}
+		// the stretched period started, its first tick is accounted by the pending SysTick exception
+		tickless_reload = 2;
+	}
+	
+	// whole ticks elapsed out of the stretched period, and cycles left to the next tick boundary
+	elapsed = tickless_ticks - 1 - (val / os_sysTickTicks);
+	left    = val % os_sysTickTicks;
+	
+	os_KernelEnterCriticalSection();
+	now = SysTick->VAL;
+	if (now > val)
+	{
+		// the stretched period ended meanwhile, the pending SysTick exception accounts for it
+		os_KernelExitCriticalSection();
+		return 0;
+	}
+	lag = val - now;
+	if (left <= (lag + OS_TICKLESS_MIN_CYCLES))
+	{
+		// too close to the tick boundary to program it: count it now and expire at the next one
+		elapsed++;
+		left += os_sysTickTicks;
+	}
+	// writing VAL does not stop the counter, it reloads the shortened period at the next processor clock
+	// (SysTick_Config selects the core clock), the tick period is back in LOAD before the period ends
+	SysTick->LOAD = left - lag - 1;
+	SysTick->VAL  = 0;
+	__DSB();
+	SysTick->LOAD = os_sysTickTicks - 1;
+	os_KernelExitCriticalSection();
+	
+	tickless_ticks  = 1;
+	tickless_reload = 0;
+	return elapsed;
+}
+
+/*! 
+    \brief Picks the thread to run and flags any context switching needed for PendSV to take care of.
+    \details Shared by the yield SVC and the kernel calls made from interrupt handlers. Ends the tickless period,
+             unless the running thread holds the scheduler lock.
+    \note Must be called with the kernel busy (SVC or critical section).
+*/
+void os_KernelReschedule (void)
+{
+#if ((ENABLE_TICKLESS_IDLE) && (ENABLE_TICKLESS_IDLE == 1))
+	uint32_t elapsed;
+	
+	// Back to the periodic tick, accounting for the ticks spent idle
+	elapsed = os_KernelTicklessExit(0);
+	if (elapsed != 0)
+	{
+		systick_count += elapsed;
+		// Wake up the threads whose timeout expired while idle and expire the timers
+		os_TimedQTick();
+		os_TimerTick();
+		os_PartitionTick();
+	}
+#endif
+	if (os_KernelLocked() != 0)
+	{
+		// the running thread holds the scheduler lock, reschedule at osKernelUnlock
+		kernel_resched = 1;
+	}
+	else
+	{
+		kernel_resched = 0;
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+		// Leave the rest of the frame to the Idle thread if the running thread gave way
+		os_CyclicYield();
+		os_CyclicTick();
+#else
+		// Run scheduler to determine if a context switch is needed
+		os_SchedPickNext();
+#endif
+	}
+	if (curr_task != next_task)
+	{ 
+		// Context switching needed
+		ScheduleContextSwitch();
+  }
+  return;
+}
+
 /*! \fn void ScheduleContextSwitch(void)
     \brief Schedules a context switch
 
@@ -318,6 +765,9 @@ void SysTick_Handler(void) // 1KHz
 */
 void ScheduleContextSwitch(void)
 {
+#if ((ENABLE_KERNEL_STATS) && (ENABLE_KERNEL_STATS == 1))
+	kernel_stats.pendsv_cnt++;
+#endif
 	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Set PendSV to pending
 	return;
 }
@@ -6,6 +6,7 @@
 #define osObjectExternal                    // define objects in main module
 #include "osObjects.h"                      // RTOS object definitions
 #include "peripherals.h"                    // Peripheral definitions
+#include "benchmark.h"                      // Kernel benchmark
 #include "stdio.h"
 
 // -------------------------------------------------------------------------
@@ -51,6 +52,13 @@ int main(void)
 	{
 		stop_cpu;
 	}		
+#if (ENABLE_BENCHMARK == 1)
+	printf("Initializing benchmark\n\r");
+  if (Init_benchmark() != 0)
+	{
+		stop_cpu;
+	}
+#endif
 	printf("Start kernel\n\r");
 	osKernelStart ();                         // start thread execution 
 	
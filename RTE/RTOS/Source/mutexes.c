@@ -0,0 +1,347 @@
+/// \file mutexes.c
+/// \brief Mutex implementation according to CMSIS interfaces
+/// \details Defines the recursive mutexes. The owner of a mutex inherits the priority of the threads blocked on it,
+///          so a thread of medium priority cannot hold off a high priority thread waiting for a low priority owner.
+
+#include "cmsis_os.h"
+#include <stdlib.h>
+#include "kernel.h"
+#include "scheduler.h"
+#include "mutexes.h"
+
+uint32_t mutex_counter = 0;         ///< Number of mutexes created
+
+// Prototypes
+osThreadId os_MutexWakeThread (osMutexId mutex_id);
+void os_MutexTake (osMutexId mutex_id, osThreadId thread_id);
+void os_MutexGive (osMutexId mutex_id);
+
+//  ==== Mutex Management ====
+
+/// Create and Initialize a Mutex object.
+/// \param[in]     mutex_def     mutex definition referenced with \ref osMutex.
+/// \return mutex ID for reference by other functions or NULL in case of error.
+/// \note MUST REMAIN UNCHANGED: \b osMutexCreate shall be consistent in every CMSIS-RTOS.
+osMutexId osMutexCreate (const osMutexDef_t *mutex_def)
+{
+	osMutexId mutex_id;
+
+	if (mutex_def == NULL)
+	{
+		return NULL;
+	}
+
+	if (mutex_counter == MAX_MUTEXES)
+	{
+		return NULL;
+	}
+
+	mutex_id = (osMutexId) calloc(1, sizeof(os_mutex_cb));
+	// no more memory available, so do not create mutex
+	if (mutex_id == NULL)
+	{
+		return NULL;
+	}
+
+	mutex_id->owner         = NULL;
+	mutex_id->lock_cnt      = 0;
+	mutex_id->owner_next    = NULL;
+	mutex_id->threads_q_cnt = 0;
+
+	mutex_counter++;
+
+	return mutex_id;
+}
+
+/// Wait until a Mutex becomes available.
+/// \details The owner can lock the mutex again, it is released after as many \ref osMutexRelease calls.
+///          While the thread is blocked, the owner runs at least at the priority of the thread.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \param[in]     millisec      timeout value or 0 in case of no time-out.
+/// \return status code that indicates the execution status of the function.
+/// \note MUST REMAIN UNCHANGED: \b osMutexWait shall be consistent in every CMSIS-RTOS.
+osStatus osMutexWait (osMutexId mutex_id, uint32_t millisec)
+{
+	uint64_t microsec = ((uint64_t) millisec) * 1000;
+	uint32_t ticks;
+	osThreadId curr_th = osThreadGetId();
+
+	if ((mutex_id == NULL) || (curr_th == NULL))
+	{
+		return osErrorParameter;
+	}
+
+	os_KernelEnterCriticalSection();
+
+	if (mutex_id->owner == NULL)
+	{
+		// mutex is free -> take mutex
+		os_MutexTake(mutex_id, curr_th);
+		os_KernelExitCriticalSection();
+		return osOK;
+	}
+
+	if (mutex_id->owner == curr_th)
+	{
+		// recursive lock
+		mutex_id->lock_cnt++;
+		os_KernelExitCriticalSection();
+		return osOK;
+	}
+
+	if (millisec == 0)
+	{
+		// mutex taken, but can't wait, so return unsuccessful
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+
+	// add thread to blocked queue on mutex
+	if (mutex_id->threads_q_cnt == MAX_THREADS)
+	{
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+	mutex_id->threads_q[mutex_id->threads_q_cnt] = curr_th;
+	mutex_id->threads_q_cnt++;
+	curr_th->mutex_id = mutex_id;
+
+	if (osWaitForever != millisec)
+	{
+		ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
+		if (ticks == 0)
+		{
+			ticks = 1;
+		}
+		// the timeout wakes the thread up if the mutex is not handed over in time
+		if (os_TimedQInsert(curr_th, ticks) != osOK)
+		{
+			os_MutexRemoveWaiter(curr_th);
+			os_KernelExitCriticalSection();
+			return osErrorResource;
+		}
+	}
+
+	// the owner (and whoever it waits for) runs at least at the priority of this thread
+	os_ThreadUpdatePriority(mutex_id->owner);
+
+	// osMutexRelease or the timeout sets the exit status and makes the thread ready again
+	if (os_ThreadBlock(TH_BLOCKED) != osOK)
+	{
+		return osErrorTimeoutResource;
+	}
+
+	// the mutex was handed over by osMutexRelease
+	return osOK;
+}
+
+/// Release a Mutex that was obtained by \ref osMutexWait.
+/// \details Once unlocked as many times as locked, the mutex goes to the thread with highest priority blocked on it,
+///          and the thread releasing it drops back from any priority inherited through it.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \return status code that indicates the execution status of the function.
+/// \note MUST REMAIN UNCHANGED: \b osMutexRelease shall be consistent in every CMSIS-RTOS.
+osStatus osMutexRelease (osMutexId mutex_id)
+{
+	osThreadId curr_th = osThreadGetId();
+	osThreadId woken;
+	osPriority priority;
+
+	if (mutex_id == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	os_KernelEnterCriticalSection();
+
+	if (mutex_id->owner != curr_th)
+	{
+		// mutex not obtained by this thread
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+
+	if (mutex_id->lock_cnt > 1)
+	{
+		// still locked by the owner
+		mutex_id->lock_cnt--;
+		os_KernelExitCriticalSection();
+		return osOK;
+	}
+
+	priority = curr_th->priority;
+	os_MutexGive(mutex_id);
+	os_ThreadUpdatePriority(curr_th);
+	woken = os_MutexWakeThread(mutex_id);
+	os_KernelExitCriticalSection();
+
+	if ((woken != NULL) || (curr_th->priority != priority))
+	{
+		// Thread(s) status change - invoke scheduler to re-evaluate running thread
+		os_KernelInvokeScheduler ();
+	}
+
+	return osOK;
+}
+
+/// Delete a Mutex that was created by \ref osMutexCreate.
+/// \param[in]     mutex_id      mutex ID obtained by \ref osMutexCreate.
+/// \return status code that indicates the execution status of the function.
+/// \note MUST REMAIN UNCHANGED: \b osMutexDelete shall be consistent in every CMSIS-RTOS.
+osStatus osMutexDelete (osMutexId mutex_id)
+{
+	if (mutex_id == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	if ((mutex_id->owner != NULL) || (mutex_id->threads_q_cnt != 0))
+	{
+		// mutex in use
+		return osErrorResource;
+	}
+
+	if (mutex_counter == 0) // this should not happen
+	{
+		return osErrorResource;
+	}
+
+	mutex_counter--;
+
+	free(mutex_id);
+
+	return osOK;
+}
+
+/// Make a thread the owner of a free mutex.
+/// \param     mutex_id   mutex object.
+/// \param     thread_id  thread object.
+/// \note Must be called with the kernel in a critical section.
+void os_MutexTake (osMutexId mutex_id, osThreadId thread_id)
+{
+	mutex_id->owner      = thread_id;
+	mutex_id->lock_cnt   = 1;
+	mutex_id->owner_next = thread_id->mutex_held;
+	thread_id->mutex_held = mutex_id;
+	return;
+}
+
+/// Take a mutex away from its owner.
+/// \param     mutex_id   mutex object.
+/// \note Must be called with the kernel in a critical section.
+void os_MutexGive (osMutexId mutex_id)
+{
+	osMutexId *link;
+
+	for ( link = &mutex_id->owner->mutex_held; *link != NULL ; link = &(*link)->owner_next )
+	{
+		if (*link == mutex_id)
+		{
+			*link = mutex_id->owner_next;
+			break;
+		}
+	}
+
+	mutex_id->owner      = NULL;
+	mutex_id->lock_cnt   = 0;
+	mutex_id->owner_next = NULL;
+	return;
+}
+
+/// Hand a free mutex over to the thread with highest priority blocked on it.
+/// \details Threads of equal priority are served in arrival order. The new owner inherits the priority
+///          of the threads still blocked on the mutex.
+/// \param     mutex_id   mutex object.
+/// \return the thread woken up, NULL if no thread is blocked.
+/// \note Must be called with the kernel in a critical section.
+osThreadId os_MutexWakeThread (osMutexId mutex_id)
+{
+	uint32_t j, idx;
+	osThreadId thread_id;
+
+	if (mutex_id->threads_q_cnt == 0)
+	{
+		// no threads blocked on this mutex
+		return NULL;
+	}
+
+	// search for the thread with highest priority waiting in the queue
+	idx = 0;
+	for ( j = 1; j < mutex_id->threads_q_cnt ; j++ )
+	{
+		if (mutex_id->threads_q[j]->priority > mutex_id->threads_q[idx]->priority)
+		{
+			idx = j; // remember the highest priority thread in the queue so far
+		}
+	}
+	thread_id = mutex_id->threads_q[idx];
+
+	// assign the mutex to the newly found thread and unblock it
+	os_MutexRemoveWaiter(thread_id);
+	os_TimedQRemove(thread_id);
+	os_MutexTake(mutex_id, thread_id);
+	os_ThreadUpdatePriority(thread_id);
+
+	thread_id->timed_ret = osOK;
+	os_SchedEnqueue(thread_id);
+
+	return thread_id;
+}
+
+/// Remove a thread from the queue of the mutex it is blocked on.
+/// \details The owner of the mutex drops back from any priority inherited from the thread.
+/// \param[in]     thread_id  thread object.
+/// \note Must be called with the kernel in a critical section.
+void os_MutexRemoveWaiter (osThreadId thread_id)
+{
+	uint32_t j;
+	osMutexId mutex_id = thread_id->mutex_id;
+
+	if (mutex_id == NULL)
+	{
+		return;
+	}
+
+	for ( j = 0; j < mutex_id->threads_q_cnt ; j++ )
+	{
+		if (mutex_id->threads_q[j] == thread_id)
+		{
+			break;
+		}
+	}
+
+	// shifting queue, keeping the arrival order
+	for ( ; (j + 1) < mutex_id->threads_q_cnt ; j++ )
+	{
+		mutex_id->threads_q[j] = mutex_id->threads_q[j+1];
+	}
+	if (j < mutex_id->threads_q_cnt)
+	{
+		mutex_id->threads_q[j] = NULL;
+		mutex_id->threads_q_cnt--;
+	}
+
+	thread_id->mutex_id = NULL;
+
+	os_ThreadUpdatePriority(mutex_id->owner);
+	return;
+}
+
+/// Release the mutexes owned by a thread and stop waiting on a mutex.
+/// \details Used when the thread is terminated, the mutexes go to the threads blocked on them.
+/// \param[in]     thread_id  thread object.
+void os_MutexRemoveThread (osThreadId thread_id)
+{
+	osMutexId mutex_id;
+
+	os_KernelEnterCriticalSection();
+	os_MutexRemoveWaiter(thread_id);
+
+	while ((mutex_id = thread_id->mutex_held) != NULL)
+	{
+		os_MutexGive(mutex_id);
+		os_MutexWakeThread(mutex_id);
+	}
+	os_KernelExitCriticalSection();
+	return;
+}
@@ -1,22 +1,62 @@
 /*! \file scheduler.c
     \brief This file contains the OS scheduler implementation
-		\details The scheduler is invoked:
-		           - at every system tick by the \ref SysTick_Handler
+		\details Fixed-priority threads are served by priority level, round-robin within a level. 
+		         EDF threads share the \ref OS_EDF_PRIORITY level and are served earliest deadline first.
+		         The cyclic executive replaces the scheduler with the dispatch of a schedule table replayed every hyperperiod.
+		         With \ref OS_AGING, the ready threads that wait too long go up a level at a time until they run.
+		         With time partitions, only the threads of the partition owning the current window and of partition 0 are eligible.
+		         A running thread with a preemption threshold is only preempted by the threads above the threshold.
+		         Rate-monotonic threads are plain fixed-priority threads here, their priorities are assigned in \ref osThreadCreate.
+		         The scheduler is invoked:
+		           - at every system tick by the \ref SysTick_Handler, after the running thread's execution budget and round-robin time slice are charged
 							 - at a thread yield
 */
 
 #include "scheduler.h"
 #include <stdint.h>
 #include "stdio.h"
+#include "CU_TM4C123.h"
 #include "osObjects.h" 
 #include "threadIdle.h"
 
 extern uint32_t  curr_task;     ///< Current task
 extern uint32_t  next_task;     ///< Next task
 
+uint32_t   ready_q_map[OS_PARTITIONS];                   ///< Ready to Run Queue bitmap of each partition, bit n is set when priority level n holds a thread
+osThreadId ready_q_h[OS_PARTITIONS][OS_PRIORITY_LEVELS]; ///< Head of each Ready to Run Queue level of each partition
+osThreadId ready_q_t[OS_PARTITIONS][OS_PRIORITY_LEVELS]; ///< Tail of each Ready to Run Queue level of each partition
+
+#if (OS_PARTITIONS > 1)
+const os_partition_window partition_frame[] = OS_PARTITION_FRAME; ///< Major frame of the partition windows
+/*! \def OS_PARTITION_WINDOWS
+         Number of windows in the major frame. */
+#define OS_PARTITION_WINDOWS (sizeof(partition_frame) / sizeof(partition_frame[0]))
+uint32_t partition_window = OS_PARTITION_WINDOWS - 1; ///< Current window of the major frame (the first tick opens window 0)
+uint32_t partition_end    = 0;                        ///< System tick the current window ends at
+#endif
+uint32_t partition_active = 0;                        ///< Partition owning the current window
+
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+const os_cyclic_entry cyclic_table[] = OS_CYCLIC_TABLE; ///< Schedule table of the cyclic executive
+/*! \def OS_CYCLIC_ENTRIES
+         Number of entries in the schedule table. */
+#define OS_CYCLIC_ENTRIES (sizeof(cyclic_table) / sizeof(cyclic_table[0]))
+uint32_t cyclic_slot[OS_CYCLIC_ENTRIES]; ///< Thread queue index of the thread of each entry, resolved at the kernel start
+uint32_t cyclic_next = 0;                ///< Next entry of the schedule table to dispatch
+uint32_t cyclic_base = 0;                ///< System tick the current hyperperiod started at
+
+void os_CyclicDispatch(uint32_t next);
+#endif
+
+osThreadId budget_q = NULL;                   ///< First of the threads with an execution budget
+uint32_t   ready_q_yield = 0;                 ///< Set when the running thread gave way, its preemption threshold does not apply to the next scheduling
+#if ((OS_AGING) && (OS_AGING == 1))
+uint32_t   aging_next = OS_AGING_PERIOD;      ///< System tick of the next aging pass
+#endif
+
 uint32_t os_ThreadGetBestThread(void);
-void os_ReevaluateBlockedThread(void);
-osStatus os_ReevaluateThread(osThreadId thread_id);
+void os_QueueAppend(osThreadId thread_id, uint32_t lvl);
+void os_QueueUnlink(osThreadId thread_id);
 
 /*! 
     \brief Prepares the next task to be run and sets \ref next_task.
@@ -30,13 +70,16 @@ void scheduler(void)
 		stop_cpu;
 	}	
 	
-	// re-evaluate blocked threads
-	os_ReevaluateBlockedThread();
-	
-	// \todo re-evaluate sleeping threads	
-	
 	// search for next thread to run
 	next = os_ThreadGetBestThread();
+	
+	// a running thread with a preemption threshold keeps the processor unless the best thread is above the threshold
+	if ((next != th_q_h) && (ready_q_yield == 0) && (th_q[th_q_h]->status == TH_RUNNING) &&
+		  (th_q[th_q_h]->threshold != osPriorityError) && (th_q[next]->priority <= th_q[th_q_h]->threshold))
+	{
+		next = th_q_h;
+	}
+	ready_q_yield = 0;
 
 	if (next != th_q_h)
 	{
@@ -57,112 +100,514 @@ void scheduler(void)
 
 
 /// \brief Get ready/running thread with highest priority.
+/// \details The highest non-empty priority level is found with a single CLZ on \ref ready_q_map,
+///          the thread at the head of that level is the one to run. The cost does not depend on the number of threads.
+///          With time partitions, the active partition wins over partition 0 at the same level.
 /// \return Thread ID of the best thread to run
 uint32_t os_ThreadGetBestThread(void)
 {
-	uint32_t i, temp = th_q_h;
-	osPriority priority = osPriorityIdle;
+	uint32_t lvl, p = 0;
+	
+#if (OS_PARTITIONS > 1)
+	// the threads of the other partitions wait for their window
+	if (__CLZ(ready_q_map[partition_active]) <= __CLZ(ready_q_map[0]))
+	{
+		p = partition_active;
+	}
+#endif
 	
-	// search for any thread that is ready to go
-	for ( i = 0; i < th_q_cnt ; i++ )
+	// check that there is a runnable thread up (above the idle level), otherwise scheduling the Idle thread
+	if ((ready_q_map[p] & ~(1UL << os_PriorityLevel(osPriorityIdle))) == 0)
 	{
-		if (th_q[i]->status == TH_READY || th_q[i]->status == TH_RUNNING)
+		return tid_threadIdle->th_q_p;
+	}
+	
+	lvl = 31 - __CLZ(ready_q_map[p]);
+	
+	return ready_q_h[p][lvl]->th_q_p;
+}
+
+/// \brief Link a thread at the tail of a Ready to Run Queue level of its partition.
+/// \details An EDF thread is linked before the first thread with a later deadline (or not EDF), 
+///          so the EDF threads of a level run earliest deadline first, ahead of its fixed-priority threads.
+/// \param thread_id Thread to link, must not be linked anywhere
+/// \param lvl       Priority level
+void os_QueueAppend(osThreadId thread_id, uint32_t lvl)
+{
+	osThreadId next = NULL;
+	uint32_t p = thread_id->partition;
+	
+	if (thread_id->sched_class == TH_CLASS_EDF)
+	{
+		for ( next = ready_q_h[p][lvl]; next != NULL ; next = next->ready_next )
 		{
-			if ( th_q[i]->priority > priority )
+			if ((next->sched_class != TH_CLASS_EDF) || ((int32_t) (next->deadline - thread_id->deadline) > 0))
 			{
-				priority = th_q[i]->priority;
-				temp = i;
-			}			
+				break;
+			}
 		}
 	}
 	
-	// check that there is a runnable thread up, otherwise scheduling the Idle thread
-	if (priority == osPriorityIdle)
+	thread_id->ready_next = next;
+	thread_id->ready_prev = (next == NULL) ? ready_q_t[p][lvl] : next->ready_prev;
+	if (thread_id->ready_prev == NULL)
+	{
+		ready_q_h[p][lvl] = thread_id;
+	}
+	else
+	{
+		thread_id->ready_prev->ready_next = thread_id;
+	}
+	if (next == NULL)
+	{
+		ready_q_t[p][lvl] = thread_id;
+	}
+	else
+	{
+		next->ready_prev = thread_id;
+	}
+	thread_id->ready_lvl = lvl;
+	
+	ready_q_map[p] |= (1UL << lvl);
+	return;
+}
+
+/// \brief Unlink a thread from the Ready to Run Queue level it is in.
+/// \param thread_id Thread to unlink
+void os_QueueUnlink(osThreadId thread_id)
+{
+	uint32_t lvl = thread_id->ready_lvl;
+	uint32_t p = thread_id->partition;
+	
+	if (lvl == OS_NO_Q)
+	{
+		return;
+	}
+	
+	if (thread_id->ready_prev == NULL)
+	{
+		ready_q_h[p][lvl] = thread_id->ready_next;
+	}
+	else
+	{
+		thread_id->ready_prev->ready_next = thread_id->ready_next;
+	}
+	
+	if (thread_id->ready_next == NULL)
+	{
+		ready_q_t[p][lvl] = thread_id->ready_prev;
+	}
+	else
+	{
+		thread_id->ready_next->ready_prev = thread_id->ready_prev;
+	}
+	
+	if (ready_q_h[p][lvl] == NULL)
+	{
+		ready_q_map[p] &= ~(1UL << lvl);
+	}
+	
+	thread_id->ready_next = NULL;
+	thread_id->ready_prev = NULL;
+	thread_id->ready_lvl  = OS_NO_Q;
+	return;
+}
+
+/// \brief Link a thread at the tail of the Ready to Run Queue level matching its priority.
+/// \details The thread is marked \ref TH_READY unless it is the running thread. Inserting a thread
+///          already in the Ready to Run Queue has no effect.
+/// \note Must be called with the kernel in a critical section.
+/// \param thread_id Thread to insert
+void os_ReadyQInsert (osThreadId thread_id)
+{
+	if (thread_id == NULL)
+	{
+		return;
+	}
+	
+	if (thread_id->status != TH_RUNNING)
+	{
+		thread_id->status = TH_READY;
+	}
+	
+	if (thread_id->ready_lvl < OS_PRIORITY_LEVELS)
+	{
+		// already in the ready to run queue
+		return;
+	}
+	
+	os_QueueAppend(thread_id, os_PriorityLevel(thread_id->priority));
+	// a fresh time slice every time the thread gets ready again
+	thread_id->slice = thread_id->quantum;
+	return;
+}
+
+/// \brief Unlink a thread from the Ready to Run Queue and set its new state.
+/// \details Blocked and sleeping threads are not linked anywhere by the scheduler: they get back in the 
+///          Ready to Run Queue from the event that wakes them up, or from \ref os_TimedQTick when they time out.
+/// \note Must be called with the kernel in a critical section.
+/// \param thread_id Thread to remove
+/// \param status    New state of the thread (\ref TH_BLOCKED, \ref TH_ASLEEP or \ref TH_DEAD)
+void os_ReadyQRemove (osThreadId thread_id, osThreadStatus status)
+{
+	if (thread_id == NULL)
+	{
+		return;
+	}
+	
+	thread_id->status = status;
+	
+	os_QueueUnlink(thread_id);
+	return;
+}
+
+/// \brief Change the priority of a thread and move it to the matching Ready to Run Queue level.
+/// \note Must be called with the kernel in a critical section.
+/// \param thread_id Thread to update
+/// \param priority  New priority
+void os_ReadyQSetPriority (osThreadId thread_id, osPriority priority)
+{
+	if (thread_id == NULL)
+	{
+		return;
+	}
+	
+	if (thread_id->ready_lvl >= OS_PRIORITY_LEVELS)
+	{
+		// not ready to run, the new priority is used when the thread is inserted again
+		thread_id->priority = priority;
+		return;
+	}
+	
+	os_QueueUnlink(thread_id);
+	thread_id->priority = priority;
+	os_QueueAppend(thread_id, os_PriorityLevel(priority));
+	return;
+}
+
+/// \brief Move a thread behind the other ready threads of the same priority.
+/// \details An EDF thread is moved behind the threads with the same or an earlier deadline.
+///          The preemption threshold of the thread does not hold off the next scheduling.
+/// \note Must be called with the kernel in a critical section.
+/// \param thread_id Thread yielding
+void os_ReadyQYield (osThreadId thread_id)
+{
+	uint32_t lvl;
+	
+	if (thread_id == NULL)
+	{
+		return;
+	}
+	
+	lvl = thread_id->ready_lvl;
+	if (lvl >= OS_PRIORITY_LEVELS)
+	{
+		return;
+	}
+	
+	thread_id->slice = thread_id->quantum;
+	ready_q_yield = 1;
+	
+	if (thread_id->ready_next == NULL)
+	{
+		// already the last one at its level
+		return;
+	}
+	
+	os_QueueUnlink(thread_id);
+	os_QueueAppend(thread_id, lvl);
+	return;
+}
+
+/// \brief Charge the current tick to the running thread's round-robin time slice.
+/// \details When the slice runs out, the thread is moved behind the other ready threads of the same priority
+///          and gets a new slice. Threads with a quantum of 0 or a preemption threshold are never time sliced.
+/// \note Called from \ref SysTick_Handler, before \ref scheduler.
+void os_RoundRobinTick(void)
+{
+	osThreadId thread_id = th_q[th_q_h];
+	
+	if (thread_id->status != TH_RUNNING)
+	{
+		return;
+	}
+	
+	if ((thread_id->quantum == 0) || (thread_id->threshold != osPriorityError))
 	{
-		if (temp != tid_threadIdle->th_q_p )
+		return;
+	}
+	
+	if (thread_id->slice > 1)
+	{
+		thread_id->slice--;
+		return;
+	}
+	
+	// time slice used up, let the next thread of the same priority run
+	os_ReadyQYield(thread_id);
+	return;
+}
+
+/// \brief Charge the system tick to the execution budget of the running thread and replenish the budgets due.
+/// \details The replenishment is due one budget period after the first tick charged since the previous replenishment.
+///          A thread that used up its budget drops to \ref OS_BUDGET_PRIORITY and gets its priority back when replenished.
+///          Only the threads with a budget are visited.
+/// \note Called from \ref SysTick_Handler, before \ref os_RoundRobinTick.
+void os_BudgetTick(void)
+{
+	osThreadId thread_id;
+	uint32_t now = osKernelSysTick();
+	
+	for ( thread_id = budget_q; thread_id != NULL ; thread_id = thread_id->budget_next )
+	{
+		if ((thread_id->budget_left != thread_id->budget) && ((int32_t) (now - thread_id->budget_repl) >= 0))
 		{
-			temp = tid_threadIdle->th_q_p; 
+			thread_id->budget_left = thread_id->budget;
+			os_ThreadUpdatePriority(thread_id);
 		}
 	}
 	
-	// if something is found, it will be returned, otherwise, curent thread is going back
-	return temp;
+	thread_id = th_q[th_q_h];
+	if ((thread_id->status != TH_RUNNING) || (thread_id->budget == 0) || (thread_id->budget_left == 0))
+	{
+		return;
+	}
+	
+	if (thread_id->budget_left == thread_id->budget)
+	{
+		// first tick charged, the replenishment period starts
+		thread_id->budget_repl = now + thread_id->budget_period;
+	}
+	
+	thread_id->budget_left--;
+	if (thread_id->budget_left == 0)
+	{
+		// budget used up, let the lower priority threads run
+		os_ThreadUpdatePriority(thread_id);
+	}
+	return;
 }
 
-/// \brief Re-evaluate all blocked threads 
-/// \details If a thread expires on a semaphore, but the semaphore is still taken, 
-///          take it out of the blocked state and into the ready to run queue
-void os_ReevaluateBlockedThread(void)
+/// \brief Add a thread to the threads with an execution budget.
+/// \param thread_id Thread with a budget, not in the list yet
+/// \note Must be called with the kernel in a critical section.
+void os_BudgetQInsert (osThreadId thread_id)
 {
-	uint32_t i;
+	thread_id->budget_next = budget_q;
+	budget_q = thread_id;
+	return;
+}
+
+/// \brief Remove a thread from the threads with an execution budget.
+/// \param thread_id Thread to remove, nothing is done if it has no budget
+/// \note Must be called with the kernel in a critical section.
+void os_BudgetQRemove (osThreadId thread_id)
+{
+	osThreadId *link;
 	
-	for ( i = 0; i < th_q_cnt ; i++ )
+	for ( link = &budget_q; *link != NULL ; link = &(*link)->budget_next )
 	{
-		if (th_q[i]->status != TH_BLOCKED)
+		if (*link == thread_id)
 		{
-			continue;
+			*link = thread_id->budget_next;
+			thread_id->budget_next = NULL;
+			break;
 		}
-		if (os_ReevaluateThread(th_q[i]) != osOK)
+	}
+	return;
+}
+
+#if (OS_PARTITIONS > 1)
+/// \brief Move on to the next partition window once the current one ends.
+/// \details The windows are counted from the system tick, so the ticks skipped by the tickless idle are accounted for
+///          and the major frame does not drift. The running thread gives way at the window boundary, whatever its preemption threshold.
+/// \note Called from \ref SysTick_Handler, before \ref scheduler.
+void os_PartitionTick(void)
+{
+	uint32_t now = osKernelSysTick();
+	
+	while ((int32_t) (now - partition_end) >= 0)
+	{
+		partition_window++;
+		if (partition_window == OS_PARTITION_WINDOWS)
 		{
-			continue;
-		}			
-	}	
+			partition_window = 0;
+		}
+		partition_active = partition_frame[partition_window].partition;
+		partition_end   += partition_frame[partition_window].ticks;
+		ready_q_yield    = 1;
+	}
 	return;
 }
 
-/// \brief Re-evaluate all blocked threads 
-/// \details If a thread expires on a semaphore, but the semaphore is still taken, 
-///          take it out of the blocked state and into the ready to run queue
-osStatus os_ReevaluateThread(osThreadId thread_id)
+/// \brief Get the number of ticks until the current partition window ends.
+/// \return Ticks left in the current window (at least 1)
+uint32_t os_PartitionNext(void)
 {
-	uint32_t semaphore_p;
-	osSemaphoreId semaphore_id;
+	int32_t left = (int32_t) (partition_end - osKernelSysTick());
+	
+	return (left > 0) ? (uint32_t) left : 1;
+}
+#endif
 
-	if ( thread_id == NULL)
-	{
-		return osErrorParameter;
-	}	
-	if ( thread_id->semaphore_id == NULL)
+#if ((OS_AGING) && (OS_AGING == 1))
+/// \brief Age the ready threads that did not run during the last aging period.
+/// \details The running thread loses its aging. Once per \ref OS_AGING_PERIOD, every ready thread below 
+///          \ref OS_AGING_PRIORITY that did not run since the previous pass goes up one level. The levels are walked 
+///          from the top, so a thread moved up is not aged twice in the same pass. Only the levels below the limit and above
+///          \ref osPriorityIdle are visited.
+/// \note Called from \ref SysTick_Handler, before \ref scheduler.
+void os_AgingTick(void)
+{
+	osThreadId thread_id = th_q[th_q_h];
+	osThreadId next;
+	uint32_t p, lvl;
+	
+	if (thread_id->status == TH_RUNNING)
 	{
-		return osErrorParameter;
+		thread_id->aging_ran = 1;
+		if (thread_id->aging != 0)
+		{
+			// got to run, back to its own priority
+			thread_id->aging = 0;
+			os_ThreadUpdatePriority(thread_id);
+		}
 	}
 	
-	if (thread_id->semaphore_p == MAX_THREADS_SEM)
+	if ((int32_t) (osKernelSysTick() - aging_next) < 0)
 	{
-		return osErrorParameter;				
+		return;
 	}
-		
-	semaphore_id = thread_id->semaphore_id;
-	semaphore_p  = thread_id->semaphore_p;
-				
-	//check if the semaphore is free
-	if (semaphore_id->threads_own_q_cnt < semaphore_id->ownCount )
+	aging_next = osKernelSysTick() + OS_AGING_PERIOD;
+	
+	for (p = 0; p < OS_PARTITIONS; p++)
 	{
-		// give the thread a chance to run 
-		thread_id->status = TH_READY;
-		return osOK;
+		// down to osPriorityLow: the Idle thread (and any idle priority filler) never ages above real work
+		for (lvl = os_PriorityLevel(OS_AGING_PRIORITY); lvl-- > os_PriorityLevel(osPriorityIdle) + 1; )
+		{
+			for ( thread_id = ready_q_h[p][lvl]; thread_id != NULL ; thread_id = next )
+			{
+				next = thread_id->ready_next;
+				if (thread_id->aging_ran != 0)
+				{
+					thread_id->aging_ran = 0;
+					continue;
+				}
+				thread_id->aging++;
+				os_ThreadUpdatePriority(thread_id);
+			}
+		}
 	}
+	return;
+}
+#endif
+
+#if ((ENABLE_CYCLIC_EXECUTIVE) && (ENABLE_CYCLIC_EXECUTIVE == 1))
+/// \brief Resolve the threads of the schedule table and dispatch the entries at offset 0.
+/// \details The first live thread created with the thread function of an entry is used. A thread function with 
+///          no thread or offsets out of order stop the processor.
+/// \note Called from the OS start SVC, in place of \ref scheduler, once the threads of the table are created.
+void os_CyclicStart(void)
+{
+	uint32_t i, th;
 	
-	// if it can wait forever, continue with the next thread
-	if (osWaitForever == semaphore_id->threads_q[semaphore_p].expiryTime &&
-			osWaitForever == semaphore_id->threads_q[semaphore_p].ticks)
+	for (i = 0; i < OS_CYCLIC_ENTRIES; i++)
 	{
-		return osOK;
+		if ((cyclic_table[i].offset >= OS_CYCLIC_HYPERPERIOD) || ((i > 0) && (cyclic_table[i].offset <= cyclic_table[i-1].offset)))
+		{
+			stop_cpu;
+		}
+		
+		if (cyclic_table[i].pthread == NULL)
+		{
+			cyclic_slot[i] = tid_threadIdle->th_q_p;
+			continue;
+		}
+		
+		for (th = 0; th < th_q_cnt; th++)
+		{
+			if ((th_q[th] != NULL) && (th_q[th]->start_p == cyclic_table[i].pthread) && (th_q[th]->status != TH_DEAD))
+			{
+				break;
+			}
+		}
+		if (th == th_q_cnt)
+		{
+			// thread not created
+			stop_cpu;
+		}
+		cyclic_slot[i] = th;
 	}
-	else // check if time expired
-	if (osKernelSysTick() == semaphore_id->threads_q[semaphore_p].expiryTime &&
-			0 == semaphore_id->threads_q[semaphore_p].ticks)
-	{			
-				// unblock thread 
-				thread_id->status = TH_READY;	
-				return osOK;					
-	}		
-	else // time did not expire yet, reduce the number of ticks
+	
+	// the Idle thread runs until the first entry
+	os_CyclicDispatch(tid_threadIdle->th_q_p);
+	cyclic_next = 0;
+	cyclic_base = osKernelSysTick();
+	os_CyclicTick();
+	return;
+}
+
+/// \brief Dispatch the entries of the schedule table that are due.
+/// \details Only the next entry is looked at, the entries are counted from the start of the hyperperiod so the 
+///          dispatch does not drift, and the ticks skipped by the tickless idle are caught up.
+/// \note Called from \ref SysTick_Handler in place of \ref scheduler.
+void os_CyclicTick(void)
+{
+	uint32_t now = osKernelSysTick();
+	
+	while ((int32_t) (now - (cyclic_base + cyclic_table[cyclic_next].offset)) >= 0)
 	{
-		if (0 < semaphore_id->threads_q[semaphore_p].ticks)
+		os_CyclicDispatch(cyclic_slot[cyclic_next]);
+		cyclic_next++;
+		if (cyclic_next == OS_CYCLIC_ENTRIES)
 		{
-			semaphore_id->threads_q[semaphore_p].ticks--;
+			cyclic_next = 0;
+			cyclic_base += OS_CYCLIC_HYPERPERIOD;
 		}
-		return osOK;
 	}
+	return;
+}
+
+/// \brief Hand the rest of the frame over to the Idle thread when the running thread yields, blocks or sleeps.
+/// \details Any other kernel call keeps the running thread until the next entry of the schedule table.
+/// \note Called from the yield SVC in place of \ref scheduler.
+void os_CyclicYield(void)
+{
+	if ((ready_q_yield != 0) || (th_q[th_q_h]->status != TH_RUNNING))
+	{
+		os_CyclicDispatch(tid_threadIdle->th_q_p);
+	}
+	ready_q_yield = 0;
+	return;
+}
+
+/// \brief Get the number of ticks until the next entry of the schedule table.
+/// \return Ticks left until the next dispatch (at least 1)
+uint32_t os_CyclicNext(void)
+{
+	int32_t left = (int32_t) (cyclic_base + cyclic_table[cyclic_next].offset - osKernelSysTick());
+	
+	return (left > 0) ? (uint32_t) left : 1;
+}
+
+/// \brief Make a thread the running thread and set \ref next_task.
+/// \details A thread that is not ready (blocked, asleep or terminated) leaves the processor to the Idle thread.
+/// \param next Thread queue index of the thread to run
+void os_CyclicDispatch(uint32_t next)
+{
+	if ((th_q[next]->status != TH_READY) && (th_q[next]->status != TH_RUNNING))
+	{
+		next = tid_threadIdle->th_q_p;
+	}
+	
+	if ( th_q[th_q_h]->status == TH_RUNNING )
+	{
+		th_q[th_q_h]->status = TH_READY;
+	}
+	th_q_h = next;
+	th_q[th_q_h]->status = TH_RUNNING;
+	
+	next_task = next;
+	return;
 }
+#endif
@@ -2,9 +2,11 @@
 /// \brief Semaphore implementation according to CMSIS interfaces
 /// \details Defines a semaphore and semaphore creation and attributes manipulation
 
+#include "CU_TM4C123.h"
 #include "cmsis_os.h" 
 #include <stdlib.h>
 #include "kernel.h"
+#include "scheduler.h"
 
 //  ==== Semaphore Management Functions ====
 
@@ -13,7 +15,7 @@
 /// \note CAN BE CHANGED: The parameter to \b osSemaphoreDef shall be consistent but the
 ///       macro body is implementation specific in every CMSIS-RTOS.
 #define osSemaphoreDef(name)  \
-const osSemaphoreDef_t os_semaphore_def_##name = { 0 }
+const osSemaphoreDef_t os_semaphore_def_##name = { 0, (osPriorityError) }
 
 /// Access a Semaphore definition.
 /// \param         name          name of the semaphore object.
@@ -31,39 +33,47 @@ uint32_t sem_counter = 0;                 ///< Semaphore Queue counter
 osStatus os_RemoveThreadFromSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id);
 osStatus os_RemoveThreadFromSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId semaphore_id);
 osStatus os_InsertThreadInSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId semaphore_id);
-osStatus os_InsertThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id, uint32_t expiryTime, uint32_t ticks);
+osStatus os_InsertThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id);
 uint32_t os_SearchThreadInSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId semaphore_id);
 uint32_t os_SearchThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id);
-osStatus os_SearchThreadAllSemaphoresBlockedQ (osThreadId thread_id, osSemaphoreId* semaphore_id_p, uint32_t* semaphore_p_p );
+osThreadId os_SemaphoreWakeThread (osSemaphoreId semaphore_id);
+uint32_t os_SemaphoreHighestWaiter (osSemaphoreId semaphore_id);
+osStatus os_SemaphoreGive (osSemaphoreId semaphore_id);
+void os_SemaphoreCeilingTake (osThreadId thread_id, osSemaphoreId semaphore_id);
+void os_SemaphoreCeilingGive (osThreadId thread_id, osSemaphoreId semaphore_id);
 
 /// Create and Initialize a Semaphore object used for managing resources.
 /// \param[in]     semaphore_def semaphore definition referenced with \ref osSemaphore.
-/// \param[in]     count         number of available resources.
+/// \param[in]     count         number of available resources, 0 for a semaphore only signalled (by interrupt handlers or threads).
 /// \return semaphore ID for reference by other functions or NULL in case of error.
 /// \note MUST REMAIN UNCHANGED: \b osSemaphoreCreate shall be consistent in every CMSIS-RTOS.
 osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t count)
 {
 	uint32_t j, sem;
-	/// If we are instantiating a thread and there is still room in the thread queue, add the thread to the queue.
-	if ( 0 < (MAX_SEMAPHORES - sem_counter))
+	
+	// count 0: no tokens to own, only the given tokens can be taken
+	if ( (count < 0) || (count > MAX_THREADS_SEM) )
 	{
-		sem = sem_counter;
-		sem_counter++;
+		return NULL;
 	}
-	else
+	
+	// a priority ceiling only makes sense on a binary semaphore used as a lock
+	if ( (semaphore_def != NULL) && (semaphore_def->ceiling != osPriorityError) &&
+	     ((count != 1) || (semaphore_def->ceiling < osPriorityIdle) || (semaphore_def->ceiling > osPriorityRealtime)) )
 	{
 		return NULL;
 	}
 	
-	if ( count <=0 )
+	/// If we are instantiating a thread and there is still room in the thread queue, add the thread to the queue.
+	if ( 0 < (MAX_SEMAPHORES - sem_counter))
 	{
-		return NULL;
+		sem = sem_counter;
+		sem_counter++;
 	}
-
-	if ( count > MAX_THREADS_SEM )
+	else
 	{
 		return NULL;
-	}	
+	}
 	
 	semaphores[sem] = (osSemaphoreId) calloc(1, sizeof(os_semaphore_cb));
 	// no more memory available, so do not create semaphore
@@ -76,8 +86,6 @@ osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t
 	for ( j = 0; j < MAX_THREADS_SEM ; j++ )
 	{
 		semaphores[sem]->threads_q[j].threadId = NULL;
-		semaphores[sem]->threads_q[j].expiryTime = 0;
-		semaphores[sem]->threads_q[j].ticks = 0;
 		
 		semaphores[sem]->threads_own_q[j] = NULL;
 	}
@@ -85,6 +93,9 @@ osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t
 	semaphores[sem]->threads_q_cnt = 0;
 	semaphores[sem]->threads_own_q_cnt = 0;
 	semaphores[sem]->ownCount = count;
+	semaphores[sem]->given_tokens = 0;
+	semaphores[sem]->ceiling = (semaphore_def != NULL) ? semaphore_def->ceiling : osPriorityError;
+	semaphores[sem]->ceiling_next = NULL;
 	
 	return semaphores[sem];
 }
@@ -98,7 +109,7 @@ osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t
 int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec)
 {	
 	uint64_t microsec = ((uint64_t) millisec) * 1000;
-	uint32_t ticks = 0, wait = 0;
+	uint32_t ticks = 0;
 	osThreadId curr_th = osThreadGetId();
 	osStatus rc;
 	
@@ -108,10 +119,19 @@ int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec)
 		return (-1);
 	}	
 
-	if ( (rc = os_InsertThreadInSemaphoreOwnerQ(curr_th,semaphore_id)) == osOK)
+	os_KernelEnterCriticalSection();
+	rc = os_InsertThreadInSemaphoreOwnerQ(curr_th,semaphore_id);
+	if ((rc == osErrorResource) && (semaphore_id->given_tokens != 0))
+	{
+		// take a token given by an interrupt handler or a thread owning none, the thread does not become an owner
+		semaphore_id->given_tokens--;
+		rc = osOK;
+	}
+	os_KernelExitCriticalSection();
+	if ( rc == osOK)
 	{
 		// semaphore is free -> take semaphore
-		return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt);
+		return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt + semaphore_id->given_tokens);
 	}	
 	
 	// check for osErrorResource to block thread
@@ -135,144 +155,123 @@ int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec)
 	{
 		return (-1); // no room in queue	
 	}
-				
-	// add thread to blocked queue on semaphore
-	if (osWaitForever == millisec)
-	{		
-		if (os_InsertThreadInSemaphoreBlockedQ(curr_th,semaphore_id, osWaitForever, osWaitForever) != osOK)
-		{
-			return (-1); // no room in queue or something else went wrong and cannot block on this semaphore
-		}			
+	
+	os_KernelEnterCriticalSection();
+	
+	// the semaphore may have been released meanwhile
+	if (os_InsertThreadInSemaphoreOwnerQ(curr_th,semaphore_id) == osOK)
+	{
+		os_KernelExitCriticalSection();
+		return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt + semaphore_id->given_tokens);
 	}
-	else
+	if (semaphore_id->given_tokens != 0)
+	{
+		semaphore_id->given_tokens--;
+		os_KernelExitCriticalSection();
+		return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt + semaphore_id->given_tokens);
+	}
+	
+	// add thread to blocked queue on semaphore
+	rc = os_InsertThreadInSemaphoreBlockedQ(curr_th,semaphore_id);
+	if ((rc == osOK) && (osWaitForever != millisec))
 	{
 		ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
-		wait = ticks + osKernelSysTick();
-		if (os_InsertThreadInSemaphoreBlockedQ(curr_th,semaphore_id, wait, ticks) != osOK)
+		if (ticks == 0)
 		{
-			return (-1); // no room in queue or something else went wrong and cannot block on this semaphore
-		}	
-	}			
-				
-	// while the semaphore is taken, keep on waiting
-	// if can no longer wait, return fail
-	while (semaphore_id->threads_own_q_cnt == semaphore_id->ownCount &&
-		     semaphore_id->threads_q[curr_th->semaphore_p].ticks != 0)
-	{
-		// set thread to blocked state and yield
-		curr_th->status = TH_BLOCKED;
-		//invoke scheduler
-		os_KernelInvokeScheduler ();						
+			ticks = 1;
+		}
+		// the timeout wakes the thread up if the semaphore is not handed over in time
+		if ((rc = os_TimedQInsert(curr_th, ticks)) != osOK)
+		{
+			os_RemoveThreadFromSemaphoreBlockedQ(curr_th, semaphore_id);
+		}
 	}
 	
-	// semaphore no longer busy or thread wait time expired
-	ticks = semaphore_id->threads_q[curr_th->semaphore_p].ticks;
-	// unblock thread and move on
-	curr_th->status = TH_READY;
-	if ((rc = os_RemoveThreadFromSemaphoreBlockedQ(curr_th, semaphore_id)) != osOK)
+	if (rc != osOK)
 	{
-		return (-1);
-	}	
+		os_KernelExitCriticalSection();
+		return (-1); // no room in queue or something else went wrong and cannot block on this semaphore
+	}
 	
-	if (ticks == 0)
+	// osSemaphoreRelease or the timeout sets the exit status and makes the thread ready again
+	if (os_ThreadBlock(TH_BLOCKED) != osOK)
 	{
 		return (-1); // timeout...
 	}
-
-	if (os_InsertThreadInSemaphoreOwnerQ(curr_th,semaphore_id) == osOK)
-	{
-		// semaphore is free -> take semaphore
-		return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt);
-	}	
 	
-	return (-1);
-				
+	// the semaphore was handed over by osSemaphoreRelease
+	return (semaphore_id->ownCount - semaphore_id->threads_own_q_cnt + semaphore_id->given_tokens);
 }
 
 
 /// Release a Semaphore token.
+/// \details An owner of the semaphore hands its token over to the thread with highest priority blocked on the semaphore,
+///          which becomes an owner. A thread owning no token (one that took a given token, or a producer) and an interrupt
+///          handler at or below \ref OS_SYSCALL_PRIORITY give one more token instead: it goes to the thread with highest priority
+///          blocked on the semaphore, which does not become an owner, or is kept for the next \ref osSemaphoreWait.
+///          A semaphore with a priority ceiling is a lock, only its owners release it. From an interrupt handler the
+///          thread woken up runs once the interrupts return.
 /// \param[in]     semaphore_id  semaphore object referenced with \ref osSemaphoreCreate.
 /// \return status code that indicates the execution status of the function.
 /// \note MUST REMAIN UNCHANGED: \b osSemaphoreRelease shall be consistent in every CMSIS-RTOS.
 osStatus osSemaphoreRelease (osSemaphoreId semaphore_id)
 {
-	uint32_t j, idx, sem_p;
-	osPriority maxPriority = osPriorityIdle;
 	osThreadId thread_id = osThreadGetId();
+	osThreadId woken;
+	osPriority priority;
 	osStatus rc;
-	osSemaphoreId sem_id;
+	uint32_t waiting;
 	
 	if ( semaphore_id == NULL )
 	{ // semaphore does not exist
 		return osErrorParameter;
 	}
-	if (semaphore_id->threads_own_q_cnt == 0)
-	{ // no owners, so nothing to release
-		return osOK;
-	}	
 	
-	if ((rc = os_RemoveThreadFromSemaphoreOwnerQ(thread_id, semaphore_id)) != osOK)
+	if ((__get_IPSR() != 0) && (semaphore_id->ceiling != osPriorityError))
 	{
-		return rc;
-	}
-	// check if not blocked on other semaphore
-	if ( (rc = os_SearchThreadAllSemaphoresBlockedQ(thread_id, &sem_id, &sem_p)) != osOK)
-	{
-		return rc;
-	}		
-
-	if (sem_p == MAX_THREADS_SEM)
-	{
-		// not blocked on any other semaphores, continue to run
-	}
-	else
-	{
-		// need to block thread on semaphore (already in the blocked queue)
-		thread_id->semaphore_id = sem_id;
-		thread_id->semaphore_p = sem_p;
-		thread_id->status = TH_BLOCKED;
+		// a ceiling semaphore is a lock, only its owner releases it
+		return osErrorISR;
 	}
 	
-	// unblock a thread from the queue based on thread priority if any left and assign the semaphore to it
-
-	if (semaphore_id->threads_q_cnt == 0)
+	os_KernelEnterCriticalSection();
+	if ((__get_IPSR() != 0) || (os_SearchThreadInSemaphoreOwnerQ(thread_id, semaphore_id) == MAX_THREADS_SEM))
 	{
-		// no threads blocked on this semaphore
-		return osOK;
-	}
-	
-	// unblock the thread with highest priority waiting in the queue
-	
-	idx = semaphore_id->threads_q_cnt;
-	maxPriority = osPriorityIdle;
-		
-	// search for the thread with highest priority waiting in the queue
-	for ( j = 0; j < semaphore_id->threads_q_cnt ; j++ )
-	{		
-		//sanity
-		if ( semaphore_id->threads_q[j].threadId != NULL)
+		if (semaphore_id->ceiling != osPriorityError)
 		{
-			if (semaphore_id->threads_q[j].threadId->priority > maxPriority )
-			{
-				maxPriority = semaphore_id->threads_q[j].threadId->priority;
-				idx = j; // remember the highest priority thread in the queue so far
-				thread_id = semaphore_id->threads_q[j].threadId;
-			}
+			// not an owner of the lock
+			os_KernelExitCriticalSection();
+			return osErrorResource;
 		}
+		// no token owned, give one more
+		waiting = semaphore_id->threads_q_cnt;
+		rc = os_SemaphoreGive(semaphore_id);
+		waiting = (semaphore_id->threads_q_cnt != waiting);
+		os_KernelExitCriticalSection();
+		if (waiting != 0)
+		{
+			// a thread was woken up - invoke scheduler, only pends PendSV from an interrupt
+			os_KernelInvokeScheduler ();
+		}
+		return rc;
 	}
 	
-	// assign the semaphore to the newly found thread and 
-	// unblock the thread (if any found) from this semaphore
-	if (idx == semaphore_id->threads_q_cnt)
+	priority = thread_id->priority;
+	if ((rc = os_RemoveThreadFromSemaphoreOwnerQ(thread_id, semaphore_id)) != osOK)
 	{
-		return osErrorValue;
-	}	
+		os_KernelExitCriticalSection();
+		return rc;
+	}
 	
-	// unblock thread 				
-	thread_id->status = TH_READY;			
+	// hand the token over to a thread blocked on the semaphore, if any
+	woken = os_SemaphoreWakeThread(semaphore_id);
+	os_KernelExitCriticalSection();
 	
-	// Thread(s) status change - invoke scheduler to re-evaluate running thread
-	os_KernelInvokeScheduler ();					
+	// the thread may have dropped from the semaphore ceiling
+	if ((woken != NULL) || (thread_id->priority != priority))
+	{
+		// Thread(s) status change - invoke scheduler to re-evaluate running thread
+		os_KernelInvokeScheduler ();
+	}
 
 	return osOK;
 }
@@ -338,6 +337,90 @@ osStatus osSemaphoreDelete (osSemaphoreId semaphore_id)
 	return osOK;
 }
 
+/// Hand a semaphore token over to the thread with highest priority blocked on the semaphore.
+/// \details The thread becomes an owner of the semaphore, leaves the blocked queue and the Waiting Queue
+///          and is made ready to run. Threads of equal priority are served in arrival order.
+/// \param     semaphore_id  semaphore object.
+/// \return the thread woken up, NULL if no thread is blocked or no token is free.
+/// \note Must be called with the kernel in a critical section.
+osThreadId os_SemaphoreWakeThread (osSemaphoreId semaphore_id)
+{
+	osThreadId thread_id;
+	
+	if (semaphore_id->threads_q_cnt == 0)
+	{
+		// no threads blocked on this semaphore
+		return NULL;
+	}
+	
+	if (semaphore_id->threads_own_q_cnt >= semaphore_id->ownCount)
+	{
+		// no token left to hand over
+		return NULL;
+	}
+	
+	thread_id = semaphore_id->threads_q[os_SemaphoreHighestWaiter(semaphore_id)].threadId;
+	
+	// assign the semaphore to the newly found thread and unblock it
+	os_RemoveThreadFromSemaphoreBlockedQ(thread_id, semaphore_id);
+	os_TimedQRemove(thread_id);
+	os_InsertThreadInSemaphoreOwnerQ(thread_id, semaphore_id);
+	
+	thread_id->timed_ret = osOK;
+	os_SchedEnqueue(thread_id);
+	
+	return thread_id;
+}
+
+/// Search the thread with highest priority blocked on a semaphore.
+/// \details Threads of equal priority are served in arrival order.
+/// \param     semaphore_id  semaphore object, with at least one thread blocked on it.
+/// \return index of the thread in the blocked queue.
+/// \note Must be called with the kernel in a critical section.
+uint32_t os_SemaphoreHighestWaiter (osSemaphoreId semaphore_id)
+{
+	uint32_t j, idx = 0;
+	
+	for ( j = 1; j < semaphore_id->threads_q_cnt ; j++ )
+	{		
+		if (semaphore_id->threads_q[j].threadId->priority > semaphore_id->threads_q[idx].threadId->priority )
+		{
+			idx = j; // remember the highest priority thread in the queue so far
+		}
+	}
+	return idx;
+}
+
+/// Give a semaphore one more token, from an interrupt handler or a thread owning no token.
+/// \details The token goes to the thread with highest priority blocked on the semaphore, which does not become
+///          an owner, or is kept for the next \ref osSemaphoreWait if no thread is blocked.
+/// \param     semaphore_id  semaphore object.
+/// \return status code that indicates the execution status of the function.
+/// \note Must be called with the kernel in a critical section.
+osStatus os_SemaphoreGive (osSemaphoreId semaphore_id)
+{
+	osThreadId thread_id;
+	
+	if (semaphore_id->threads_q_cnt == 0)
+	{
+		if (semaphore_id->given_tokens == MAX_THREADS_SEM)
+		{
+			// too many tokens not taken
+			return osErrorResource;
+		}
+		semaphore_id->given_tokens++;
+		return osOK;
+	}
+	
+	thread_id = semaphore_id->threads_q[os_SemaphoreHighestWaiter(semaphore_id)].threadId;
+	os_RemoveThreadFromSemaphoreBlockedQ(thread_id, semaphore_id);
+	os_TimedQRemove(thread_id);
+	
+	thread_id->timed_ret = osOK;
+	os_SchedEnqueue(thread_id);
+	return osOK;
+}
+
 /// Remove thread from all semaphore queues.
 /// \param     thread_id  thread object.
 /// \return status code that indicates the execution status of the function.
@@ -357,8 +440,16 @@ osStatus os_SemaphoreRemoveThread (osThreadId thread_id)
 	
 	for ( i = 0; i < sem_counter ; i++ )
 	{		
+		// interrupt handlers can edit the queues of the semaphore as well
+		os_KernelEnterCriticalSection();
 		os_RemoveThreadFromSemaphoreBlockedQ(thread_id,semaphores[i]);
-		os_RemoveThreadFromSemaphoreOwnerQ(thread_id,semaphores[i]);	
+		if (os_SearchThreadInSemaphoreOwnerQ(thread_id,semaphores[i]) != MAX_THREADS_SEM)
+		{
+			// the token is free again, pass it on
+			os_RemoveThreadFromSemaphoreOwnerQ(thread_id,semaphores[i]);	
+			os_SemaphoreWakeThread(semaphores[i]);
+		}
+		os_KernelExitCriticalSection();
 	}
 	
 	return osOK;
@@ -412,8 +503,6 @@ osStatus os_RemoveThreadFromSemaphoreBlockedQ (osThreadId thread_id, osSemaphore
 	semaphore_id->threads_q[idx].threadId->semaphore_p = MAX_THREADS_SEM;
 	// remove the thread from the semaphore's queue
 	semaphore_id->threads_q[idx].threadId = NULL;
-	semaphore_id->threads_q[idx].expiryTime = 0;	
-	semaphore_id->threads_q[idx].ticks = 0;
 	
 	for ( j = idx; j < (semaphore_id->threads_q_cnt) - 1 ; j++ )
 	{
@@ -427,8 +516,6 @@ osStatus os_RemoveThreadFromSemaphoreBlockedQ (osThreadId thread_id, osSemaphore
 	}	
 	
 	semaphore_id->threads_q[(semaphore_id->threads_q_cnt) - 1].threadId = NULL;
-	semaphore_id->threads_q[(semaphore_id->threads_q_cnt) - 1].expiryTime = 0;
-	semaphore_id->threads_q[(semaphore_id->threads_q_cnt) - 1].ticks = 0;
 	
 	semaphore_id->threads_q_cnt--;
 
@@ -484,6 +571,8 @@ osStatus os_RemoveThreadFromSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId
 
 	semaphore_id->threads_own_q[(semaphore_id->threads_own_q_cnt) - 1] = NULL;
 	semaphore_id->threads_own_q_cnt--;	
+	
+	os_SemaphoreCeilingGive(thread_id, semaphore_id);
 		
 	return osOK;
 }
@@ -523,16 +612,17 @@ osStatus os_InsertThreadInSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId s
 	semaphore_id->threads_own_q[semaphore_id->threads_own_q_cnt] = thread_id;
 	semaphore_id->threads_own_q_cnt++;
 	
+	os_SemaphoreCeilingTake(thread_id, semaphore_id);
+	
 	return osOK;
 }
 
 /// Insert thread in the blocked semaphore queue.
 /// \param     thread_id  thread object.
 /// \param     semaphore_id  semaphore object
-/// \param     expiryTime to  give up waiting on semaphore
-/// \param     ticks to spend on semaphore
 /// \return status code that indicates the execution status of the function.
-osStatus os_InsertThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id, uint32_t expiryTime, uint32_t ticks)
+/// \note The timeout, if any, is kept by the kernel timeout service (\ref os_TimedQInsert).
+osStatus os_InsertThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId semaphore_id)
 {
 	if ( thread_id == NULL)
 	{
@@ -556,8 +646,6 @@ osStatus os_InsertThreadInSemaphoreBlockedQ (osThreadId thread_id, osSemaphoreId
 	}
 	
 	semaphore_id->threads_q[semaphore_id->threads_q_cnt].threadId = thread_id;
-	semaphore_id->threads_q[semaphore_id->threads_q_cnt].expiryTime = expiryTime;
-	semaphore_id->threads_q[semaphore_id->threads_q_cnt].ticks = ticks;
 	
 	thread_id->semaphore_id = semaphore_id;
 	thread_id->semaphore_p = semaphore_id->threads_q_cnt;
@@ -627,51 +715,47 @@ uint32_t os_SearchThreadInSemaphoreOwnerQ (osThreadId thread_id, osSemaphoreId s
 	return idx;
 }
 
-/// Search for the thread in all blocked semaphore queue.
+/// Raise the new owner of a semaphore with a priority ceiling to the ceiling.
+/// \details The semaphore is linked in the list of ceiling semaphores owned by the thread,
+///          so the thread priority is computed without looking at any other semaphore.
 /// \param     thread_id  thread object.
-/// \param     semaphore_id_p  pointer to semaphore object for returning
-/// \param     semaphore_p_p  pointer to index to semaphore object for returning
-/// \return index withing one of the semaphores the thread is blocked; 
-///   - MAX_THREADS_SEM if not found or error
-osStatus os_SearchThreadAllSemaphoresBlockedQ (osThreadId thread_id, osSemaphoreId* semaphore_id_p, uint32_t* semaphore_p_p )
+/// \param     semaphore_id  semaphore object
+/// \note Must be called with the kernel in a critical section.
+void os_SemaphoreCeilingTake (osThreadId thread_id, osSemaphoreId semaphore_id)
 {
-	uint32_t i, j;
-
-	if ( thread_id == NULL)
+	if (semaphore_id->ceiling == osPriorityError)
 	{
-		return osErrorParameter;
-	}	
-
-	if ( semaphore_id_p == NULL)
-	{
-		return osErrorParameter;
-	}	
+		return;
+	}
+	
+	semaphore_id->ceiling_next = thread_id->ceiling_held;
+	thread_id->ceiling_held = semaphore_id;
+	os_ThreadUpdatePriority(thread_id);
+	return;
+}
 
-	if ( semaphore_p_p == NULL)
+/// Drop the former owner of a semaphore with a priority ceiling back from the ceiling.
+/// \param     thread_id  thread object.
+/// \param     semaphore_id  semaphore object
+/// \note Must be called with the kernel in a critical section.
+void os_SemaphoreCeilingGive (osThreadId thread_id, osSemaphoreId semaphore_id)
+{
+	osSemaphoreId *link;
+	
+	if (semaphore_id->ceiling == osPriorityError)
 	{
-		return osErrorParameter;
+		return;
 	}
 	
-	*semaphore_p_p = MAX_THREADS_SEM;
-	*semaphore_id_p = NULL;
-	
-  // search for the thread in all semaphore queues
-	for ( i = 0; i < sem_counter ; i++ )
-	{	
-		if (semaphores[i]->threads_q_cnt != 0 )
-		{	
-			for ( j = 0; j < semaphores[i]->threads_q_cnt ; j++ )
-			{		
-				if (semaphores[i]->threads_q[j].threadId == thread_id)
-				{
-					*semaphore_p_p = j;
-					*semaphore_id_p = semaphores[i];
-					break;
-				}
-			}	
+	for ( link = &thread_id->ceiling_held; *link != NULL ; link = &(*link)->ceiling_next )
+	{
+		if (*link == semaphore_id)
+		{
+			*link = semaphore_id->ceiling_next;
+			break;
 		}
 	}
-	
-	return osOK;
+	semaphore_id->ceiling_next = NULL;
+	os_ThreadUpdatePriority(thread_id);
+	return;
 }
-
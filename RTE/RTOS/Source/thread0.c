@@ -82,7 +82,7 @@ void thread0 (void const *argument)
 			}	
 			
 			task0(); // thread code 
-			count1Sec();
+			osDelay(1000);
 			task0();
 			
 			if (addTraceProtected("thread0 set priority to osPriorityLow") != TRACE_OK)
@@ -74,7 +74,7 @@ void thread1 (void const *argument)
 			}	
 			
 			task1(); // thread code 
-  		count1Sec();			
+  		osDelay(1000);
 			task1();
 			
 			if (addTraceProtected("thread1 release sem0 attempt") != TRACE_OK)
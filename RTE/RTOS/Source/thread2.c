@@ -75,7 +75,7 @@ void thread2 (void const *argument)
 			}	
 			
 			task2(); // thread code
-			count1Sec();
+			osDelay(1000);
 			task2();
 			
 			if (addTraceProtected("thread2 release sem0 attempt") != TRACE_OK)
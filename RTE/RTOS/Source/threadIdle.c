@@ -4,7 +4,9 @@
 		         The Idle Thread does not support termination. It is created by the kernel at initialization and will run as long as the kernel does.
 */
 
+#include "CU_TM4C123.h"
 #include "osObjects.h"
+#include "kernel.h"
 #include "trace.h"
 #include "threadIdle.h"
 
@@ -54,7 +56,14 @@ void threadIdle (void const *argument)
 		// if other work scheduled, this mechanism can be removed or adapted as necessary
 		while (getTraceCounter() <= 3)
 		{
+#if ((ENABLE_TICKLESS_IDLE) && (ENABLE_TICKLESS_IDLE == 1))
+			__WFI();                     // sleep until an interrupt, the kernel stretches the tick while idle
+#if ((ENABLE_COOPERATIVE) && (ENABLE_COOPERATIVE == 1))
+			osThreadYield();             // the tick does not preempt, let the threads woken up run
+#endif
+#else
 			osThreadYield();             // suspend thread
+#endif
 		}
 		
 		if (addTraceProtected("threadIdle back from yield") != TRACE_OK)
@@ -5,6 +5,9 @@
 
 #include "cmsis_os.h" 
 #include "kernel.h"
+#include "scheduler.h"
+#include "mutexes.h"
+#include "irqthreads.h"
 #include <stdlib.h>
 
 //  ==== Thread Management ====
@@ -18,17 +21,28 @@
 ///       macro body is implementation specific in every CMSIS-RTOS.
 #define osThreadDef(name, priority, instances, stacksz)  \
 const osThreadDef_t os_thread_def_##name = \
-{ (name), (priority), (instances), (stacksz)  }
+{ (name), (priority), (instances), (stacksz), (OS_ROBIN_QUANTUM), 0, 0, 0, 0, 0, osPriorityError, 0  }
 
 osThreadId th_q[MAX_THREADS]; ///< Ready to Run Queue (thread queue)
 uint32_t th_q_h = 0;          ///< Ready to Run Queue Head 
 uint32_t th_q_cnt = 0;        ///< Ready to Run Queue thread counter
 
-osThreadId timed_q[MAX_THREADS]; ///< Waiting Queue for sleeping threads
-uint32_t timed_q_h;              ///< Waiting Queue Head 
+osThreadId timed_q[MAX_THREADS]; ///< Waiting Queue for threads waiting with a timeout, sorted by expiry (the next to expire is last)
+uint32_t timed_q_tick = 0;       ///< Waiting Queue base: system tick the delta of the last entry is counted from
 uint32_t timed_q_cnt = 0;        ///< Waiting Queue thread counter
 
+uint32_t rm_period[MAX_THREADS];    ///< Periods of the rate-monotonic task set under analysis (ticks)
+uint32_t rm_wcet[MAX_THREADS];      ///< Worst-case execution times of the rate-monotonic task set under analysis (ticks)
+osPriority rm_priority[MAX_THREADS]; ///< Priorities of the rate-monotonic task set under analysis
+
 void os_ThreadRemoveThread(osThreadId thread_id);
+void os_ThreadTimeout(osThreadId thread_id);
+osPriority os_ThreadEffectivePriority (osThreadId thread_id);
+osStatus os_ThreadSleep (osThreadId thread_id, uint32_t ticks);
+uint32_t os_ThreadRMSet (osThreadId skip);
+osPriority os_ThreadRMPriority (uint32_t n, uint32_t period);
+osStatus os_ThreadRMAdmission (uint32_t period, uint32_t wcet, osThreadId skip);
+void os_ThreadRMAssign (void);
 
 /// Create a thread and add it to Active Threads and set it to state READY.
 /// \param[in]     thread_def    thread definition referenced with \ref osThread.
@@ -38,6 +52,7 @@ void os_ThreadRemoveThread(osThreadId thread_id);
 osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument)
 {
 	uint32_t th, instances, dead = MAX_THREADS;
+	osThreadClass sched_class;
 	
 	// the definition does not exist, nothing to feed from, so exiting
 	if ( thread_def == NULL )
@@ -85,8 +100,52 @@ osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument)
 		return NULL;
 	}	
 	
+	// the preemption threshold can only protect the thread further than its priority does
+	if ( (thread_def->threshold != osPriorityError) && 
+		   ((thread_def->threshold > osPriorityRealtime) || (thread_def->threshold < thread_def->tpriority)) )
+	{
+		return NULL;
+	}
+	
+	// check that the partition exists
+	if ( thread_def->partition >= OS_PARTITIONS )
+	{
+		return NULL;
+	}
+	
+	// the budget must fit in its replenishment period
+	if ( (thread_def->budget != 0) && (thread_def->budget > thread_def->budget_period) )
+	{
+		return NULL;
+	}
+	
+	// pick the scheduling class, rate-monotonic threads leave the priority to the kernel
+	if (thread_def->period == 0)
+	{
+		sched_class = TH_CLASS_FIXED;
+	}
+	else if (thread_def->tpriority == osPriorityError)
+	{
+		sched_class = TH_CLASS_RM;
+	}
+	else
+	{
+		sched_class = TH_CLASS_EDF;
+	}
+	
+	if (sched_class == TH_CLASS_RM)
+	{
+		// check that the task set stays schedulable with this thread
+		if ( (thread_def->wcet == 0) || (thread_def->wcet > thread_def->period) ||
+			   (os_ThreadRMAdmission((uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->period) * 1000),
+			                         (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->wcet) * 1000),
+			                         (dead == MAX_THREADS) ? NULL : th_q[dead]) != osOK) )
+		{
+			return NULL;
+		}
+	}
 	// check that the priority is whithin limits
-	if ( (thread_def->tpriority < osPriorityIdle) || (thread_def->tpriority > osPriorityRealtime) )
+	else if ( (thread_def->tpriority < osPriorityIdle) || (thread_def->tpriority > osPriorityRealtime) )
 	{
 		return NULL;
 	}
@@ -130,13 +189,45 @@ osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument)
 	}
 	
 	th_q[th]->th_q_p   = th;
-	th_q[th]->priority = thread_def->tpriority;
+	// the priority of a rate-monotonic thread is assigned once it joins the task set
+	th_q[th]->priority = (sched_class == TH_CLASS_RM) ? (osPriority) OS_RM_PRIORITY_MIN : thread_def->tpriority;
+	th_q[th]->base_priority = th_q[th]->priority;
 	th_q[th]->status   = TH_READY;
 	
+	th_q[th]->ready_lvl  = OS_NO_Q;
+	th_q[th]->ready_next = NULL;
+	th_q[th]->ready_prev = NULL;
+	
+	th_q[th]->quantum = thread_def->quantum;
+	th_q[th]->slice   = thread_def->quantum;
+	th_q[th]->threshold = thread_def->threshold;
+	th_q[th]->partition = thread_def->partition;
+	
+	// EDF and rate-monotonic scheduling classes: the first job is released rel_time after the creation
+	th_q[th]->sched_class = sched_class;
+	th_q[th]->period   = (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->period) * 1000);
+	th_q[th]->wcet     = (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->wcet) * 1000);
+	th_q[th]->release  = osKernelSysTick() + (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->rel_time) * 1000);
+	th_q[th]->deadline = th_q[th]->release + th_q[th]->period;
+	
+	th_q[th]->budget        = (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->budget) * 1000);
+	th_q[th]->budget_left   = th_q[th]->budget;
+	th_q[th]->budget_period = (uint32_t) osKernelSysTickMicroSec(((uint64_t) thread_def->budget_period) * 1000);
+	th_q[th]->budget_repl   = 0;
+	th_q[th]->budget_next   = NULL;
+	
+	th_q[th]->aging     = 0;
+	th_q[th]->aging_ran = 0;
+	th_q[th]->lock_cnt  = 0;
+	
 	th_q[th]->semaphore_id = NULL;
 	th_q[th]->semaphore_p  = MAX_THREADS_SEM;
 	
-	th_q[th]->timed_q_p   = NULL;
+	th_q[th]->mutex_id   = NULL;
+	th_q[th]->mutex_held = NULL;
+	th_q[th]->ceiling_held = NULL;
+	
+	th_q[th]->timed_q_p   = MAX_THREADS; /// not in the Waiting Queue
 	th_q[th]->timed_ret   = osOK;
 	th_q[th]->time_count  = 0;    /// Ready-to-Run	
 	
@@ -154,6 +245,29 @@ osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument)
 	// Whether already running or not, the kernel should be able to allocate stack space to the thread
 	// Need the stack_size and the start_p already initialized in order to allocate the stack for the thread
 	os_KernelStackAlloc(th);	
+	
+	// the stack is in place, the thread can now be picked by the scheduler
+	os_KernelEnterCriticalSection();
+	if (sched_class == TH_CLASS_RM)
+	{
+		// the new period may push the longer periods down a level
+		os_ThreadRMAssign();
+	}
+	if (th_q[th]->budget != 0)
+	{
+		os_BudgetQInsert(th_q[th]);
+	}
+	if ((th_q[th]->period != 0) && (th_q[th]->release != osKernelSysTick()) &&
+		  (os_TimedQInsert(th_q[th], th_q[th]->release - osKernelSysTick()) == osOK))
+	{
+		// EDF thread released later, asleep until then
+		th_q[th]->status = TH_ASLEEP;
+	}
+	else
+	{
+		os_SchedEnqueue(th_q[th]);
+	}
+	os_KernelExitCriticalSection();
 
 	return th_q[th];
 }
@@ -200,6 +314,11 @@ osStatus osThreadTerminate (osThreadId thread_id)
 /// \note MUST REMAIN UNCHANGED: \b osThreadYield shall be consistent in every CMSIS-RTOS.
 osStatus osThreadYield (void)
 {
+	// let the other ready threads of the same priority go first
+	os_KernelEnterCriticalSection();
+	os_SchedYield(osThreadGetId());
+	os_KernelExitCriticalSection();
+	
 	//invoke scheduler
 	os_KernelInvokeScheduler ();
 		
@@ -220,7 +339,24 @@ osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority)
 	{		
 		return osErrorValue;
   }
-  thread_id->priority = priority;
+	
+	// check that the priority is whithin limits
+	if ( (priority < osPriorityIdle) || (priority > osPriorityRealtime) )
+	{
+		return osErrorValue;
+	}
+	
+	if (thread_id->sched_class == TH_CLASS_RM)
+	{
+		// the priority follows the period, the admission test relies on it
+		return osErrorResource;
+	}
+	
+	// a priority inherited through a mutex or a semaphore ceiling is kept until the mutex or semaphore is released
+	os_KernelEnterCriticalSection();
+	thread_id->base_priority = priority;
+	os_ThreadUpdatePriority(thread_id);
+	os_KernelExitCriticalSection();
 	return osOK;
 }
 
@@ -239,41 +375,561 @@ osPriority osThreadGetPriority (osThreadId thread_id)
 	return thread_id->priority;
 }
 
+/// Wait for the next period of an EDF or rate-monotonic thread (end of the current job).
+/// \details The release time is counted from the previous release rather than from the current time,
+///          so the periods do not drift. The comparison with the current system tick is done modulo 2^32.
+/// \return \ref osEventTimeout when the thread slept until its next release, \ref osOK when the next release 
+///         already passed (overrun) and the thread did not sleep, or an error code.
+osStatus osThreadPeriodWait (void)
+{
+	osThreadId curr_th = osThreadGetId();
+	int32_t left;
+	
+	if ((curr_th == NULL) || (curr_th->period == 0))
+	{
+		// not a periodic thread
+		return osErrorResource;
+	}
+	
+	os_KernelEnterCriticalSection();
+	curr_th->release += curr_th->period;
+	curr_th->deadline = curr_th->release + curr_th->period;
+	left = (int32_t) (curr_th->release - osKernelSysTick());
+	if (left <= 0)
+	{
+		// next job already released, compete again with its later deadline
+		os_SchedYield(curr_th);
+		os_KernelExitCriticalSection();
+		os_KernelInvokeScheduler ();
+		return osOK;
+	}
+	os_KernelExitCriticalSection();
+	
+	return os_ThreadSleep(curr_th, (uint32_t) left);
+}
 
-/// Remove thread from all the lists.
-/// \param thread_id  Thread ID of the thread to remove
-void os_ThreadRemoveThread(osThreadId thread_id)
+/// Collect the periods and execution times of the live rate-monotonic threads into \ref rm_period and \ref rm_wcet.
+/// \param skip  Thread left out of the set (NULL for none)
+/// \return the number of threads collected.
+uint32_t os_ThreadRMSet (osThreadId skip)
 {
-	uint32_t i, idx;
+	uint32_t th, n = 0;
+	
+	for (th = 0; th < th_q_cnt; th++)
+	{
+		if ((th_q[th] != NULL) && (th_q[th] != skip) && (th_q[th]->sched_class == TH_CLASS_RM) && (th_q[th]->status != TH_DEAD))
+		{
+			rm_period[n] = th_q[th]->period;
+			rm_wcet[n]   = th_q[th]->wcet;
+			n++;
+		}
+	}
+	
+	return n;
+}
 
-	// remove from any semaphore queues
-	os_SemaphoreRemoveThread(thread_id);
+/// Get the rate-monotonic priority of a period.
+/// \details Each distinct period shorter than this one in \ref rm_period takes the level below the previous one,
+///          starting from \ref OS_RM_PRIORITY_MAX. Once \ref OS_RM_PRIORITY_MIN is reached, the longer periods share it.
+/// \param n       Number of threads in \ref rm_period
+/// \param period  Period in ticks
+/// \return the priority of the threads with this period.
+osPriority os_ThreadRMPriority (uint32_t n, uint32_t period)
+{
+	uint32_t i, j, rank = 0;
 	
-	// remove from timed queue and update the queue
-	if (timed_q_cnt != 0)
+	for (i = 0; i < n; i++)
+	{
+		if (rm_period[i] >= period)
+		{
+			continue;
+		}
+		// count each shorter period once
+		for (j = 0; (j < i) && (rm_period[j] != rm_period[i]); j++)
+		{
+		}
+		if (j == i)
+		{
+			rank++;
+		}
+	}
+	
+	if (rank >= (OS_RM_PRIORITY_MAX - OS_RM_PRIORITY_MIN))
+	{
+		return (osPriority) OS_RM_PRIORITY_MIN;
+	}
+	return (osPriority) (OS_RM_PRIORITY_MAX - rank);
+}
+
+/// Response-time schedulability test of the rate-monotonic threads with a new thread.
+/// \details The worst-case response time of each thread is its execution time plus the preemptions by the threads 
+///          of higher or equal priority: R = C + sum(ceil(R / Tj) * Cj), iterated until R stops changing.
+///          Threads sharing a priority level are counted as preempting each other, so the test is safe 
+///          when the periods outnumber the levels. The load of the other scheduling classes is not accounted for.
+/// \param period  Period in ticks of the new thread
+/// \param wcet    Worst-case execution time in ticks of the new thread
+/// \param skip    Terminated thread the new thread takes the place of (NULL for none)
+/// \return \ref osOK when every thread completes within its period, \ref osErrorResource otherwise.
+osStatus os_ThreadRMAdmission (uint32_t period, uint32_t wcet, osThreadId skip)
+{
+	uint32_t i, j, n, resp, prev;
+	
+	n = os_ThreadRMSet(skip);
+	if (n == MAX_THREADS)
+	{
+		return osErrorResource;
+	}
+	rm_period[n] = period;
+	rm_wcet[n]   = wcet;
+	n++;
+	
+	for (i = 0; i < n; i++)
+	{
+		rm_priority[i] = os_ThreadRMPriority(n, rm_period[i]);
+	}
+	
+	for (i = 0; i < n; i++)
+	{
+		resp = rm_wcet[i];
+		do
+		{
+			prev = resp;
+			resp = rm_wcet[i];
+			for (j = 0; j < n; j++)
+			{
+				if ((j != i) && (rm_priority[j] >= rm_priority[i]))
+				{
+					resp += ((prev + rm_period[j] - 1) / rm_period[j]) * rm_wcet[j];
+				}
+			}
+			if (resp > rm_period[i])
+			{
+				// deadline missed
+				return osErrorResource;
+			}
+		} while (resp != prev);
+	}
+	
+	return osOK;
+}
+
+/// Give every live rate-monotonic thread the priority of its period.
+/// \note Must be called with the kernel in a critical section.
+void os_ThreadRMAssign (void)
+{
+	uint32_t th, n;
+	
+	n = os_ThreadRMSet(NULL);
+	for (th = 0; th < th_q_cnt; th++)
+	{
+		if ((th_q[th] != NULL) && (th_q[th]->sched_class == TH_CLASS_RM) && (th_q[th]->status != TH_DEAD))
+		{
+			th_q[th]->base_priority = os_ThreadRMPriority(n, th_q[th]->period);
+			os_ThreadUpdatePriority(th_q[th]);
+		}
+	}
+	return;
+}
+
+/// Get the priority a thread should run at.
+/// \details Only the semaphores and mutexes owned by the thread are visited.
+/// \param thread_id  Thread ID of the thread
+/// \return the base priority of the thread (lowered when the execution budget is used up, raised by aging), raised to the ceiling of the semaphores it owns 
+///         and to the priority of the threads blocked on the mutexes it owns.
+osPriority os_ThreadEffectivePriority (osThreadId thread_id)
+{
+	osPriority priority = thread_id->base_priority;
+	osSemaphoreId semaphore_id;
+#if ((OS_MUTEX_INHERITANCE) && (OS_MUTEX_INHERITANCE == 1))
+	uint32_t j;
+	osMutexId mutex_id;
+#endif
+	
+	if ((thread_id->budget != 0) && (thread_id->budget_left == 0) && (priority > (osPriority) OS_BUDGET_PRIORITY))
+	{
+		// budget used up, demoted until replenished
+		priority = (osPriority) OS_BUDGET_PRIORITY;
+	}
+	
+#if ((OS_AGING) && (OS_AGING == 1))
+	if ((thread_id->aging != 0) && (priority < (osPriority) OS_AGING_PRIORITY))
+	{
+		// waited too long, aged up to the aging limit at most
+		priority = (osPriority) (priority + thread_id->aging);
+		if (priority > (osPriority) OS_AGING_PRIORITY)
+		{
+			priority = (osPriority) OS_AGING_PRIORITY;
+		}
+	}
+#endif
+	
+	for ( semaphore_id = thread_id->ceiling_held; semaphore_id != NULL ; semaphore_id = semaphore_id->ceiling_next )
+	{
+		if (semaphore_id->ceiling > priority)
+		{
+			priority = semaphore_id->ceiling;
+		}
+	}
+	
+#if ((OS_MUTEX_INHERITANCE) && (OS_MUTEX_INHERITANCE == 1))
+	for ( mutex_id = thread_id->mutex_held; mutex_id != NULL ; mutex_id = mutex_id->owner_next )
 	{
-		for ( i = 0; i < timed_q_cnt ; i++ )
+		for ( j = 0; j < mutex_id->threads_q_cnt ; j++ )
 		{
-			if (timed_q[i] == thread_id )
+			if (mutex_id->threads_q[j]->priority > priority)
 			{
-				timed_q[i] = NULL;
-				idx = i;
+				priority = mutex_id->threads_q[j]->priority;
 			}
 		}
+	}
+#endif
+	return priority;
+}
+
+/// Update the priority of a thread from its base priority, the ceiling of the semaphores it owns and the priority of the threads waiting on its mutexes.
+/// \details The change is passed on to the owner of the mutex the thread is blocked on, and so on (transitive inheritance).
+///          The chain is at most \ref MAX_THREADS long, a longer one can only be a deadlock.
+/// \param thread_id  Thread ID of the thread
+/// \note Must be called with the kernel in a critical section.
+void os_ThreadUpdatePriority (osThreadId thread_id)
+{
+	uint32_t depth;
+	osPriority priority;
+	
+	for ( depth = 0; (thread_id != NULL) && (depth < MAX_THREADS) ; depth++ )
+	{
+		priority = os_ThreadEffectivePriority(thread_id);
+		if (priority == thread_id->priority)
+		{
+			return;
+		}
+		os_SchedSetPriority(thread_id, priority);
 		
-		for ( i = idx; i < timed_q_cnt - 1 ; i++ )
+		if (thread_id->mutex_id == NULL)
 		{
-				timed_q[i] = timed_q[i+1];
-				timed_q[i]->timed_q_p = i; 	
+			return;
 		}
-		timed_q[timed_q_cnt - 1] = NULL;
-		timed_q_cnt--;	
-	}	
+		thread_id = thread_id->mutex_id->owner;
+	}
+	return;
+}
+
+//  ==== Generic Wait Functions ====
+
+/// Wait for Timeout (Time Delay).
+/// \details The thread is put to sleep (\ref TH_ASLEEP) in the Waiting Queue and left out of the Ready to Run Queue,
+///          so it costs no scheduler work until the tick it wakes up at.
+/// \param[in]     millisec      time delay value
+/// \return status code that indicates the execution status of the function.
+osStatus osDelay (uint32_t millisec)
+{
+	uint64_t microsec = ((uint64_t) millisec) * 1000;
+	uint32_t ticks;
+	
+	if (millisec == 0)
+	{
+		// nothing to wait for
+		return osOK;
+	}
+	
+	ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
+	if (ticks == 0)
+	{
+		ticks = 1;
+	}
+	
+	return os_ThreadSleep(osThreadGetId(), ticks);
+}
+
+/// Wait until the next period boundary (Periodic Time Delay).
+/// \details The wake up time is counted from the previous one rather than from the current time, so the time 
+///          spent running between two calls does not make the period drift. The comparison with the current 
+///          system tick is done modulo 2^32, so it survives the wrap around of \ref osKernelSysTick.
+/// \param[in,out] previous_wake  system tick of the previous wake up, advanced by one period on return. 
+///                               Initialize it with \ref osKernelSysTick before the first call.
+/// \param[in]     millisec       period value
+/// \return \ref osEventTimeout when the thread slept until the period boundary, \ref osOK when the boundary
+///         already passed (overrun) and the thread did not sleep, or an error code.
+osStatus osDelayUntil (uint32_t *previous_wake, uint32_t millisec)
+{
+	uint64_t microsec = ((uint64_t) millisec) * 1000;
+	uint32_t ticks;
+	int32_t left;
+	
+	if ((previous_wake == NULL) || (millisec == 0))
+	{
+		return osErrorParameter;
+	}
+	
+	ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
+	if (ticks == 0)
+	{
+		ticks = 1;
+	}
+	
+	*previous_wake += ticks;
+	left = (int32_t) (*previous_wake - osKernelSysTick());
+	if (left <= 0)
+	{
+		// period boundary missed, do not sleep
+		return osOK;
+	}
+	
+	return os_ThreadSleep(osThreadGetId(), (uint32_t) left);
+}
+
+/// Put a thread to sleep for a number of ticks.
+/// \param thread_id  Thread ID of the running thread
+/// \param ticks      Number of ticks to sleep
+/// \return \ref osEventTimeout once the thread woke up, or an error code.
+osStatus os_ThreadSleep (osThreadId thread_id, uint32_t ticks)
+{
+	if (thread_id == NULL)
+	{
+		return osErrorOS;
+	}
+	
+	os_KernelEnterCriticalSection();
+	if (os_TimedQInsert(thread_id, ticks) != osOK)
+	{
+		os_KernelExitCriticalSection();
+		return osErrorResource;
+	}
+	// the timeout sets the exit status and makes the thread ready again
+	return os_ThreadBlock(TH_ASLEEP);
+}
+
+/// Take the running thread out of the ready threads and wait until it is woken up.
+/// \details The waker (or the timeout) sets the exit status in timed_ret and makes the thread ready again.
+///          The critical section is left before waiting.
+/// \param status  state of the thread while waiting: \ref TH_BLOCKED or \ref TH_ASLEEP
+/// \return the exit status set by the waker: \ref osOK, \ref osEventTimeout or an error code.
+/// \note Must be called with the kernel in a critical section (one level), after the thread was queued where its waker finds it.
+osStatus os_ThreadBlock (osThreadStatus status)
+{
+	osThreadId curr_th = osThreadGetId();
+	
+	curr_th->timed_ret = osErrorResource;
+	os_SchedDequeue(curr_th, status);
+	os_KernelExitCriticalSection();
+	
+	// the Idle thread is scheduled even when blocked, so keep yielding until woken up
+	while (curr_th->timed_ret == osErrorResource)
+	{
+		//invoke scheduler
+		os_KernelInvokeScheduler ();
+	}
+	
+	return curr_th->timed_ret;
+}
+
+/// Remove thread from all the lists.
+/// \param thread_id  Thread ID of the thread to remove
+void os_ThreadRemoveThread(osThreadId thread_id)
+{
+	// remove from any semaphore queues
+	os_SemaphoreRemoveThread(thread_id);
+	
+	// release the mutexes owned and stop waiting on a mutex
+	os_MutexRemoveThread(thread_id);
+	
+#if ((ENABLE_IRQ_THREADS) && (ENABLE_IRQ_THREADS == 1))
+	// unbind the interrupt source handled by the thread, if any
+	os_IrqRemoveThread(thread_id);
+#endif
+	
+	// remove from timed queue and update the queue
+	os_KernelEnterCriticalSection();
+	os_TimedQRemove(thread_id);
+	os_BudgetQRemove(thread_id);
+	os_KernelExitCriticalSection();
 	
 	// set the thread in dead state
-	thread_id->status = TH_DEAD;
+	os_KernelEnterCriticalSection();
+	os_SchedDequeue(thread_id, TH_DEAD);
+	os_KernelExitCriticalSection();
 	// stack size already allocated, so just park the thread in TH_DEAD state
 	// this particular thread cannot be 'revived', it will be dead until the end of the program/forever
 	return;
 }
 
+
+//  ==== Timeout Management ====
+
+/*
+ The Waiting Queue is a delta list kept in timed_q[]: entries are sorted by expiry time, the next to expire 
+ at timed_q[timed_q_cnt - 1], and the time_count of an entry holds the number of ticks between the expiry 
+ of the entry just before it and its own expiry. The next to expire counts from timed_q_tick.
+ The tick only looks at the next entry to expire, whatever the number of threads waiting, and expired 
+ entries are taken off the end of the array without moving the others.
+*/
+
+/// Add a thread to the Waiting Queue, it will time out after the given number of ticks.
+/// \details Threads with the same expiry time time out in the order they were added.
+/// \param thread_id  Thread ID of the thread waiting
+/// \param ticks      Number of ticks before the thread times out
+/// \return status code that indicates the execution status of the function.
+/// \note Must be called with the kernel in a critical section.
+osStatus os_TimedQInsert (osThreadId thread_id, uint32_t ticks)
+{
+	uint32_t i, j, delta;
+	
+	if (thread_id == NULL)
+	{
+		return osErrorParameter;
+	}
+	
+	if (thread_id->timed_q_p != MAX_THREADS)
+	{
+		// already waiting on a timeout
+		return osErrorResource;
+	}
+	
+	if (timed_q_cnt == MAX_THREADS)
+	{
+		return osErrorResource;
+	}
+	
+	if (timed_q_cnt == 0)
+	{
+		timed_q_tick = osKernelSysTick();
+	}
+	
+	// count from the Waiting Queue base, skipping the entries expiring before (or with) this one
+	delta = ticks + (osKernelSysTick() - timed_q_tick);
+	for ( i = timed_q_cnt; i > 0 ; i-- )
+	{
+		if (delta < timed_q[i-1]->time_count)
+		{
+			break;
+		}
+		delta -= timed_q[i-1]->time_count;
+	}
+	
+	// make room at index i, moving up the entries expiring before this one
+	for ( j = timed_q_cnt; j > i ; j-- )
+	{
+		timed_q[j] = timed_q[j-1];
+		timed_q[j]->timed_q_p = j;
+	}
+	timed_q_cnt++;
+	
+	thread_id->time_count = delta;
+	thread_id->timed_q_p  = i;
+	timed_q[i] = thread_id;
+	if (i > 0)
+	{
+		// the entry expiring just after counts from this one now
+		timed_q[i-1]->time_count -= delta;
+	}
+	
+	return osOK;
+}
+
+/// Remove a thread from the Waiting Queue, if it is there.
+/// \param thread_id  Thread ID of the thread to remove
+/// \note Must be called with the kernel in a critical section.
+void os_TimedQRemove (osThreadId thread_id)
+{
+	uint32_t i, idx;
+	
+	if (thread_id == NULL)
+	{
+		return;
+	}
+	
+	idx = thread_id->timed_q_p;
+	if ((idx >= timed_q_cnt) || (timed_q[idx] != thread_id))
+	{
+		// not waiting on a timeout
+		return;
+	}
+	
+	if (idx > 0)
+	{
+		// the entry expiring just after counts from the previous one now
+		timed_q[idx-1]->time_count += thread_id->time_count;
+	}
+	
+	for ( i = idx; i < timed_q_cnt - 1 ; i++ )
+	{
+			timed_q[i] = timed_q[i+1];
+			timed_q[i]->timed_q_p = i; 	
+	}
+	timed_q[timed_q_cnt - 1] = NULL;
+	timed_q_cnt--;
+	
+	thread_id->timed_q_p = MAX_THREADS;
+	return;
+}
+
+/// Wake up the threads in the Waiting Queue whose timeout expired.
+/// \details Called by the kernel at every tick, and after the ticks skipped while idle. 
+///          Only the threads timing out now are visited.
+/// \note Must be called with the kernel in a critical section.
+void os_TimedQTick (void)
+{
+	uint32_t elapsed;
+	osThreadId thread_id;
+	
+	elapsed = osKernelSysTick() - timed_q_tick;
+	timed_q_tick = osKernelSysTick();
+	
+	while (timed_q_cnt > 0)
+	{
+		thread_id = timed_q[timed_q_cnt - 1];
+		if (thread_id->time_count > elapsed)
+		{
+			thread_id->time_count -= elapsed;
+			break;
+		}
+		elapsed -= thread_id->time_count;
+		
+		// the next to expire is the last entry, nothing to move
+		timed_q[timed_q_cnt - 1] = NULL;
+		timed_q_cnt--;
+		thread_id->timed_q_p = MAX_THREADS;
+		thread_id->time_count = 0;
+		
+		os_ThreadTimeout(thread_id);
+	}
+	return;
+}
+
+/// Get the number of ticks until the earliest timeout in the Waiting Queue.
+/// \return Ticks until the next timeout, 0 if one already expired, \ref osWaitForever if no thread can time out
+uint32_t os_TimedQNext (void)
+{
+	uint32_t elapsed;
+	
+	if (timed_q_cnt == 0)
+	{
+		return osWaitForever;
+	}
+	
+	elapsed = osKernelSysTick() - timed_q_tick;
+	if (timed_q[timed_q_cnt - 1]->time_count <= elapsed)
+	{
+		return 0;
+	}
+	
+	return (timed_q[timed_q_cnt - 1]->time_count - elapsed);
+}
+
+/// Wake up a thread whose timeout expired.
+/// \param thread_id  Thread ID of the thread that timed out
+void os_ThreadTimeout(osThreadId thread_id)
+{
+	// give up waiting on the semaphore
+	if (thread_id->semaphore_id != NULL)
+	{
+		os_RemoveThreadFromSemaphoreBlockedQ(thread_id, thread_id->semaphore_id);
+	}
+	
+	// give up waiting on the mutex, the owner drops any priority inherited from this thread
+	os_MutexRemoveWaiter(thread_id);
+	
+	thread_id->timed_ret = osEventTimeout;
+	os_SchedEnqueue(thread_id);
+	return;
+}
@@ -0,0 +1,477 @@
+/// \file timers.c
+/// \brief Timer implementation according to CMSIS interfaces
+/// \details Defines the one-shot and periodic timers, the Timer Queue they run in and the timer thread
+///          dispatching their call back functions.
+
+#include "cmsis_os.h"
+#include <stdlib.h>
+#include "osObjects.h"
+#include "kernel.h"
+#include "scheduler.h"
+#include "timers.h"
+
+/*
+ The running timers are kept in the Timer Queue, a delta list in timer_q[] like the Waiting Queue of the threads:
+ entries are sorted by expiry time, the next to expire at timer_q[timer_q_cnt - 1], and the time_count of a timer
+ holds the number of ticks between the expiry of the timer just before it and its own expiry. The next to expire
+ counts from timer_q_tick. A timer costs nothing between its expirations.
+*/
+
+osTimerId timer_q[MAX_TIMERS];      ///< Timer Queue, sorted by expiry (the next to expire is last)
+uint32_t timer_q_tick = 0;          ///< Timer Queue base: system tick the delta of the last entry is counted from
+uint32_t timer_q_cnt = 0;           ///< Timer Queue timer counter
+uint32_t timer_counter = 0;         ///< Number of timers created
+
+#if (OS_TIMER_ISR_DISPATCH == 0)
+osTimerId timer_pend_h = NULL;      ///< Head of the timers waiting for the timer thread
+osTimerId timer_pend_t = NULL;      ///< Tail of the timers waiting for the timer thread
+uint32_t timer_wait = 0;            ///< flag whether the timer thread is blocked waiting for a timer to expire
+
+osThreadDef (threadTimer, (osPriority) OS_TIMER_PRIORITY, 1, 100);  ///< thread definition
+osThreadId tid_threadTimer;                                         ///< thread id
+#endif
+
+// Prototypes
+osStatus os_TimerQInsert (osTimerId timer_id, uint32_t ticks);
+void os_TimerQRemove (osTimerId timer_id);
+void os_TimerDispatch (osTimerId timer_id);
+void os_TimerPendRemove (osTimerId timer_id);
+
+//  ==== Timer Management Functions ====
+
+/// Create a timer.
+/// \param[in]     timer_def     timer object referenced with \ref osTimer.
+/// \param[in]     type          osTimerOnce for one-shot or osTimerPeriodic for periodic behavior.
+/// \param[in]     argument      argument to the timer call back function.
+/// \return timer ID for reference by other functions or NULL in case of error.
+/// \note MUST REMAIN UNCHANGED: \b osTimerCreate shall be consistent in every CMSIS-RTOS.
+osTimerId osTimerCreate (const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+	osTimerId timer_id;
+
+	if ((timer_def == NULL) || (timer_def->ptimer == NULL))
+	{
+		return NULL;
+	}
+
+	if ((type != osTimerOnce) && (type != osTimerPeriodic))
+	{
+		return NULL;
+	}
+
+	if (timer_counter == MAX_TIMERS)
+	{
+		return NULL;
+	}
+
+	timer_id = (osTimerId) calloc(1, sizeof(os_timer_cb));
+	// no more memory available, so do not create timer
+	if (timer_id == NULL)
+	{
+		return NULL;
+	}
+
+	timer_id->ptimer       = timer_def->ptimer;
+	timer_id->argument     = argument;
+	timer_id->type         = type;
+	timer_id->load         = 0;
+	timer_id->time_count   = 0;
+	timer_id->timer_q_p    = MAX_TIMERS; // not running
+	timer_id->pending      = 0;
+	timer_id->pending_next = NULL;
+
+	timer_counter++;
+
+	return timer_id;
+}
+
+/// Start or restart a timer.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \param[in]     millisec      time delay value of the timer.
+/// \return status code that indicates the execution status of the function.
+/// \note MUST REMAIN UNCHANGED: \b osTimerStart shall be consistent in every CMSIS-RTOS.
+osStatus osTimerStart (osTimerId timer_id, uint32_t millisec)
+{
+	uint64_t microsec = ((uint64_t) millisec) * 1000;
+	uint32_t ticks;
+	osStatus rc;
+
+	if (timer_id == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	if (millisec == 0)
+	{
+		return osErrorValue;
+	}
+
+	ticks = (uint32_t) osKernelSysTickMicroSec(microsec);
+	if (ticks == 0)
+	{
+		ticks = 1;
+	}
+
+	os_KernelEnterCriticalSection();
+	// restart the timer if running
+	os_TimerQRemove(timer_id);
+	timer_id->load = ticks;
+	rc = os_TimerQInsert(timer_id, ticks);
+	os_KernelExitCriticalSection();
+
+	return rc;
+}
+
+/// Stop the timer.
+/// \details Expirations not yet dispatched by the timer thread are dropped, even for a one-shot timer that already expired.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \return \ref osOK if the timer was running or had expirations to dispatch, \ref osErrorResource if there was nothing to stop.
+/// \note MUST REMAIN UNCHANGED: \b osTimerStop shall be consistent in every CMSIS-RTOS.
+osStatus osTimerStop (osTimerId timer_id)
+{
+	uint32_t stopped;
+
+	if (timer_id == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	// SysTick expires the timers, check and stop in one go
+	os_KernelEnterCriticalSection();
+	stopped = ((timer_id->timer_q_p != MAX_TIMERS) || (timer_id->pending != 0));
+	os_TimerQRemove(timer_id);
+	os_TimerPendRemove(timer_id);
+	os_KernelExitCriticalSection();
+
+	if (stopped == 0)
+	{
+		// timer not running
+		return osErrorResource;
+	}
+	return osOK;
+}
+
+/// Delete a timer that was created by \ref osTimerCreate.
+/// \param[in]     timer_id      timer ID obtained by \ref osTimerCreate.
+/// \return status code that indicates the execution status of the function.
+/// \note MUST REMAIN UNCHANGED: \b osTimerDelete shall be consistent in every CMSIS-RTOS.
+osStatus osTimerDelete (osTimerId timer_id)
+{
+	if (timer_id == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	if (timer_counter == 0) // this should not happen
+	{
+		return osErrorResource;
+	}
+
+	os_KernelEnterCriticalSection();
+	os_TimerQRemove(timer_id);
+	os_TimerPendRemove(timer_id);
+	os_KernelExitCriticalSection();
+
+	timer_counter--;
+
+	free(timer_id);
+
+	return osOK;
+}
+
+/// Expire the timers of the Timer Queue whose time is up.
+/// \details Called by the kernel at every tick, and after the ticks skipped while idle.
+///          Only the timers expiring now are visited. A periodic timer is put back for its next period,
+///          counted from its expiry time so that late ticks do not make it drift.
+/// \note Must be called with the kernel in a critical section.
+void os_TimerTick (void)
+{
+	uint32_t late;
+	osTimerId timer_id;
+
+	while (timer_q_cnt > 0)
+	{
+		timer_id = timer_q[timer_q_cnt - 1];
+		if (timer_id->time_count > (osKernelSysTick() - timer_q_tick))
+		{
+			break;
+		}
+
+		// the rest of the queue counts from this expiry
+		timer_q_tick += timer_id->time_count;
+
+		// the next to expire is the last entry, nothing to move
+		timer_q[timer_q_cnt - 1] = NULL;
+		timer_q_cnt--;
+		timer_id->timer_q_p = MAX_TIMERS;
+
+		if (timer_id->type == osTimerPeriodic)
+		{
+			late = osKernelSysTick() - timer_q_tick;
+			os_TimerQInsert(timer_id, timer_id->load - (late % timer_id->load));
+		}
+
+		os_TimerDispatch(timer_id);
+	}
+
+	// count the next to expire from now on
+	if (timer_q_cnt > 0)
+	{
+		timer_q[timer_q_cnt - 1]->time_count -= osKernelSysTick() - timer_q_tick;
+	}
+	timer_q_tick = osKernelSysTick();
+	return;
+}
+
+/// Get the number of ticks until the next timer expires.
+/// \return Ticks until the next expiry, 0 if one already expired, \ref osWaitForever if no timer is running
+uint32_t os_TimerQNext (void)
+{
+	uint32_t elapsed;
+
+	if (timer_q_cnt == 0)
+	{
+		return osWaitForever;
+	}
+
+	elapsed = osKernelSysTick() - timer_q_tick;
+	if (timer_q[timer_q_cnt - 1]->time_count <= elapsed)
+	{
+		return 0;
+	}
+
+	return (timer_q[timer_q_cnt - 1]->time_count - elapsed);
+}
+
+/// Add a timer to the Timer Queue, it will expire after the given number of ticks.
+/// \param timer_id   timer object.
+/// \param ticks      Number of ticks before the timer expires
+/// \return status code that indicates the execution status of the function.
+/// \note Must be called with the kernel in a critical section.
+osStatus os_TimerQInsert (osTimerId timer_id, uint32_t ticks)
+{
+	uint32_t i, j, delta;
+
+	if (timer_id->timer_q_p != MAX_TIMERS)
+	{
+		// already running
+		return osErrorResource;
+	}
+
+	if (timer_q_cnt == MAX_TIMERS)
+	{
+		return osErrorResource;
+	}
+
+	if (timer_q_cnt == 0)
+	{
+		timer_q_tick = osKernelSysTick();
+	}
+
+	// count from the Timer Queue base, skipping the timers expiring before (or with) this one
+	delta = ticks + (osKernelSysTick() - timer_q_tick);
+	for ( i = timer_q_cnt; i > 0 ; i-- )
+	{
+		if (delta < timer_q[i-1]->time_count)
+		{
+			break;
+		}
+		delta -= timer_q[i-1]->time_count;
+	}
+
+	// make room at index i, moving up the timers expiring before this one
+	for ( j = timer_q_cnt; j > i ; j-- )
+	{
+		timer_q[j] = timer_q[j-1];
+		timer_q[j]->timer_q_p = j;
+	}
+	timer_q_cnt++;
+
+	timer_id->time_count = delta;
+	timer_id->timer_q_p  = i;
+	timer_q[i] = timer_id;
+	if (i > 0)
+	{
+		// the timer expiring just after counts from this one now
+		timer_q[i-1]->time_count -= delta;
+	}
+
+	return osOK;
+}
+
+/// Remove a timer from the Timer Queue, if it is there.
+/// \param timer_id   timer object.
+/// \note Must be called with the kernel in a critical section.
+void os_TimerQRemove (osTimerId timer_id)
+{
+	uint32_t i, idx;
+
+	idx = timer_id->timer_q_p;
+	if ((idx >= timer_q_cnt) || (timer_q[idx] != timer_id))
+	{
+		// not running
+		return;
+	}
+
+	if (idx > 0)
+	{
+		// the timer expiring just after counts from the previous one now
+		timer_q[idx-1]->time_count += timer_id->time_count;
+	}
+
+	for ( i = idx; i < timer_q_cnt - 1 ; i++ )
+	{
+			timer_q[i] = timer_q[i+1];
+			timer_q[i]->timer_q_p = i;
+	}
+	timer_q[timer_q_cnt - 1] = NULL;
+	timer_q_cnt--;
+
+	timer_id->timer_q_p = MAX_TIMERS;
+	return;
+}
+
+#if (OS_TIMER_ISR_DISPATCH == 1)
+
+/// Run the call back function of an expired timer, straight from the SysTick interrupt.
+/// \param timer_id   timer object.
+void os_TimerDispatch (osTimerId timer_id)
+{
+	timer_id->ptimer(timer_id->argument);
+	return;
+}
+
+/// Nothing is left for a timer thread to dispatch.
+/// \param timer_id   timer object.
+void os_TimerPendRemove (osTimerId timer_id)
+{
+	return;
+}
+
+#else
+
+/// Hand an expired timer over to the timer thread and wake the timer thread up.
+/// \details A timer expiring again before the timer thread got to it is queued only once, its expirations are counted.
+/// \param timer_id   timer object.
+/// \note Must be called with the kernel in a critical section.
+void os_TimerDispatch (osTimerId timer_id)
+{
+	if (timer_id->pending++ == 0)
+	{
+		timer_id->pending_next = NULL;
+		if (timer_pend_t == NULL)
+		{
+			timer_pend_h = timer_id;
+		}
+		else
+		{
+			timer_pend_t->pending_next = timer_id;
+		}
+		timer_pend_t = timer_id;
+	}
+
+	if (timer_wait != 0)
+	{
+		// the timer thread waits for work, not blocked in a call back
+		timer_wait = 0;
+		tid_threadTimer->timed_ret = osOK;
+		os_SchedEnqueue(tid_threadTimer);
+	}
+	return;
+}
+
+/// Drop the expirations of a timer not yet dispatched by the timer thread.
+/// \param timer_id   timer object.
+/// \note Must be called with the kernel in a critical section.
+void os_TimerPendRemove (osTimerId timer_id)
+{
+	osTimerId prev = NULL, curr;
+
+	if (timer_id->pending == 0)
+	{
+		return;
+	}
+
+	for ( curr = timer_pend_h; curr != NULL ; curr = curr->pending_next )
+	{
+		if (curr == timer_id)
+		{
+			if (prev == NULL)
+			{
+				timer_pend_h = curr->pending_next;
+			}
+			else
+			{
+				prev->pending_next = curr->pending_next;
+			}
+			if (timer_pend_t == curr)
+			{
+				timer_pend_t = prev;
+			}
+			break;
+		}
+		prev = curr;
+	}
+
+	timer_id->pending = 0;
+	timer_id->pending_next = NULL;
+	return;
+}
+
+/*! \fn int Init_threadTimer (void)
+    \brief Initializing the timer thread
+*/
+int Init_threadTimer (void)
+{
+  tid_threadTimer = osThreadCreate (osThread(threadTimer), NULL);
+  if(!tid_threadTimer) return(-1);
+
+  return(0);
+}
+
+/*! \fn void threadTimer (void const *argument)
+    \brief Thread definition for the timer thread.
+    \details Runs the call back functions of the expired timers, in expiry order,
+             and stays blocked while there is nothing to dispatch.
+    \param argument A pointer to the list of arguments.
+*/
+void threadTimer (void const *argument)
+{
+	osTimerId timer_id;
+	os_ptimer ptimer;
+	void *timer_arg;
+	uint32_t count;
+
+  while (1)
+	{
+		os_KernelEnterCriticalSection();
+		timer_id = timer_pend_h;
+		if (timer_id == NULL)
+		{
+			// nothing to dispatch, block until a timer expires
+			timer_wait = 1;
+			os_ThreadBlock(TH_BLOCKED);
+			continue;
+		}
+
+		timer_pend_h = timer_id->pending_next;
+		if (timer_pend_h == NULL)
+		{
+			timer_pend_t = NULL;
+		}
+		count     = timer_id->pending;
+		ptimer    = timer_id->ptimer;
+		timer_arg = timer_id->argument;
+		timer_id->pending      = 0;
+		timer_id->pending_next = NULL;
+		os_KernelExitCriticalSection();
+
+		// the timer may be stopped or deleted by its call back, only the copies are used
+		while (count-- > 0)
+		{
+			ptimer(timer_arg);
+		}
+  }
+}
+
+#endif
@@ -0,0 +1,137 @@
+/// \file workqueue.c
+/// \brief Interrupt work queue implementation
+/// \details Interrupt handlers capture their data and queue a work item with \ref osWorkSubmit,
+///          the worker thread runs the processing at \ref OS_WORK_PRIORITY with the interrupts enabled.
+
+#include "CU_TM4C123.h"
+#include "cmsis_os.h"
+#include "osObjects.h"
+#include "kernel.h"
+#include "scheduler.h"
+#include "workqueue.h"
+
+#if ((ENABLE_WORK_QUEUE) && (ENABLE_WORK_QUEUE == 1))
+
+/*
+ The work queue is a ring of OS_WORK_QUEUE_SIZE items indexed by free running counters. The submitters reserve the
+ item at work_q_head with LDREX/STREX, so nested interrupt handlers never wait on each other or mask the interrupts,
+ then write the item and mark it ready. The worker thread is the only consumer: it takes the item at work_q_tail
+ once ready and frees it by moving work_q_tail on. The kernel is only entered to wake up the worker thread.
+*/
+
+os_work_item work_q[OS_WORK_QUEUE_SIZE];  ///< Work Queue
+volatile uint32_t work_q_head = 0;        ///< Work Queue counter of the items reserved by the submitters
+volatile uint32_t work_q_tail = 0;        ///< Work Queue counter of the items taken by the worker thread
+uint32_t work_q_lost = 0;                 ///< Number of work items refused on a full queue
+uint32_t work_wait = 0;                   ///< flag whether the worker thread is blocked waiting for work
+
+osThreadDef (threadWork, (osPriority) OS_WORK_PRIORITY, 1, 100);  ///< thread definition
+osThreadId tid_threadWork;                                        ///< thread id
+
+/// Queue a work item for the worker thread.
+/// \details Callable from interrupt handlers at or below \ref OS_SYSCALL_PRIORITY and from threads.
+///          The items run in the order they were submitted.
+/// \param[in]     pwork         work item function.
+/// \param[in]     data          data passed to the work item function.
+/// \return status code that indicates the execution status of the function.
+/// \note RavenOS specific extension.
+osStatus osWorkSubmit (os_pwork pwork, uint32_t data)
+{
+	uint32_t head;
+	uint32_t woken = 0;
+	os_work_item *item;
+
+	if (pwork == NULL)
+	{
+		return osErrorParameter;
+	}
+
+	// reserve an item, an interrupt handler preempting this one may be reserving one as well
+	do
+	{
+		head = __LDREXW(&work_q_head);
+		if ((head - work_q_tail) >= OS_WORK_QUEUE_SIZE)
+		{
+			// the worker thread is behind, refuse the item
+			__CLREX();
+			work_q_lost++;
+			return osErrorResource;
+		}
+	} while (__STREXW(head + 1, &work_q_head) != 0);
+
+	item = &work_q[head & (OS_WORK_QUEUE_SIZE - 1)];
+	item->pwork = pwork;
+	item->data  = data;
+	// the item is complete before the worker thread can see it
+	__DMB();
+	item->ready = 1;
+
+	os_KernelEnterCriticalSection();
+	if (work_wait != 0)
+	{
+		// the worker thread waits for work
+		work_wait = 0;
+		tid_threadWork->timed_ret = osOK;
+		os_SchedEnqueue(tid_threadWork);
+		woken = 1;
+	}
+	os_KernelExitCriticalSection();
+
+	if (woken != 0)
+	{
+		// Thread(s) status change - invoke scheduler to re-evaluate running thread (only pends PendSV from an interrupt)
+		os_KernelInvokeScheduler ();
+	}
+
+	return osOK;
+}
+
+/*! \fn int Init_threadWork (void)
+    \brief Initializing the worker thread
+*/
+int Init_threadWork (void)
+{
+  tid_threadWork = osThreadCreate (osThread(threadWork), NULL);
+  if(!tid_threadWork) return(-1);
+
+  return(0);
+}
+
+/*! \fn void threadWork (void const *argument)
+    \brief Thread definition for the worker thread.
+    \details Runs the work items in the order they were submitted
+             and stays blocked while there is nothing to run.
+    \param argument A pointer to the list of arguments.
+*/
+void threadWork (void const *argument)
+{
+	os_work_item *item;
+	os_pwork pwork;
+	uint32_t data;
+
+  while (1)
+	{
+		item = &work_q[work_q_tail & (OS_WORK_QUEUE_SIZE - 1)];
+
+		os_KernelEnterCriticalSection();
+		if (item->ready == 0)
+		{
+			// nothing to run, block until a work item is submitted
+			work_wait = 1;
+			os_ThreadBlock(TH_BLOCKED);
+			continue;
+		}
+		os_KernelExitCriticalSection();
+
+		pwork = item->pwork;
+		data  = item->data;
+		item->ready = 0;
+		// the item is taken before the submitters can reuse it
+		__DMB();
+		work_q_tail++;
+
+		pwork(data);
+  }
+}
+
+#endif